@@ -68,6 +68,18 @@ workspace "assembler"
 		includedirs { "source/lib", "source/lib/utility/", "source/lib/assembler" }
 		links { "utility", "assembler" }
 
+	project "benchmark"
+		kind "ConsoleApp"
+		location "source/app/benchmark"
+
+		targetdir ("output/bin/%{prj.name}")
+		objdir ("output/obj/%{prj.name}")
+
+		files { "source/app/benchmark/**.cpp", "source/app/benchmark/**.h" }
+
+		includedirs { "source/lib", "source/lib/utility/", "source/lib/assembler" }
+		links { "utility", "assembler" }
+
 	project "basm"
 		kind "ConsoleApp"
 		location "source/app/basm"
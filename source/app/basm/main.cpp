@@ -2,6 +2,13 @@
 
 #include <assembler/frontend.h>
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 // assembler passes
 // optimization
 #include <assembler/passes/cfg_analyze_pass.h>
@@ -35,16 +42,90 @@ struct arguments {
 	// control flow graph (emitted when the path is not empty)
 	utility::filepath cfg_output_path;
 
+	// number of threads used for parsing
+	u64 job_count = 1;
+
 	// source code of the program to assemble
-	utility::dynamic_string source;
+	utility::string_view source;
+};
+
+// read-only view of the source file, on posix systems the file is memory mapped so that the lexer
+// can run directly over the page cache without copying it into a separate buffer first
+class source_file {
+public:
+	source_file() = default;
+	source_file(const source_file& other) = delete;
+
+	~source_file() {
+#ifndef _WIN32
+		if(m_mapping) {
+			munmap(m_mapping, m_size);
+		}
+#endif
+	}
+
+	[[nodiscard]] auto open(const char* path) -> bool {
+#ifndef _WIN32
+		const i32 descriptor = ::open(path, O_RDONLY);
+
+		if(descriptor == -1) {
+			return false;
+		}
+
+		struct stat info;
+
+		if(fstat(descriptor, &info) == -1) {
+			close(descriptor);
+			return false;
+		}
+
+		m_size = static_cast<u64>(info.st_size);
+
+		// empty files can't be mapped
+		if(m_size > 0) {
+			m_mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+			if(m_mapping == MAP_FAILED) {
+				m_mapping = nullptr;
+				close(descriptor);
+				return false;
+			}
+
+			// the lexer only ever walks forward
+			madvise(m_mapping, m_size, MADV_SEQUENTIAL);
+		}
+
+		close(descriptor);
+		return true;
+#else
+		m_text = utility::file::read(path);
+		return true;
+#endif
+	}
+
+	[[nodiscard]] auto get_view() const -> utility::string_view {
+#ifndef _WIN32
+		return utility::string_view(static_cast<const char*>(m_mapping), m_size);
+#else
+		return utility::string_view(m_text.get_data(), m_text.get_size());
+#endif
+	}
+private:
+#ifndef _WIN32
+	void* m_mapping = nullptr;
+	u64 m_size = 0;
+#else
+	utility::dynamic_string m_text;
+#endif
 };
 
 void display_help() {
 	utility::console::print(
-		"usage: basm [-h|-v|[[-c <outfile>][-f <format>][-o <outfile>] <filename>]]\n"
+		"usage: basm [-h|-v|[[-c <outfile>][-f <format>][-j <count>][-o <outfile>] <filename>]]\n"
 		"  -v --version    print the BASM version number\n"
 		"  -o --output     write the output to outfile\n"
 		"  -f --format     select output file format { bin, elf } [bin]\n"
+		"  -j --jobs       parse large sources using up to count threads [1]\n"
 		"  -h --help       display this help message\n"
 		"  -c --cfg        generate a graphviz CFG of the processed program and write it to outfile\n"
 		"\n"
@@ -73,8 +154,16 @@ void display_version() {
 }
 
 [[nodiscard]] auto assemble(const arguments& args) -> i32 {
+	// smaller chunks aren't worth the threading overhead
+	constexpr u64 min_chunk_size = 1024 * 1024;
+	u64 chunk_count = args.source.get_size() / min_chunk_size;
+
+	if(chunk_count > args.job_count) {
+		chunk_count = args.job_count;
+	}
+
 	baremetal::assembler::frontend frontend(args.source);
-	const auto result = frontend.parse();
+	const auto result = frontend.parse_parallel(chunk_count);
 
 	if(result.has_error()) {
 		utility::console::print_err("error: {}\n", result.get_error());
@@ -131,6 +220,15 @@ auto main(i32 argc, const char** argv) -> i32 {
 				return 1;
 			}
 		}
+		else if(compare_commands("-j", "--jobs", argv[argi])) {
+			MISSING_ARG_VERIFY();
+			args.job_count = strtoull(argv[argi], nullptr, 10);
+
+			if(args.job_count == 0) {
+				utility::console::print_err("error: invalid job count '{}' (type '--help' for help)\n", argv[argi]);
+				return 1;
+			}
+		}
 		else if(compare_commands("-c", "--cfg", argv[argi])) {
 			MISSING_ARG_VERIFY();
 			args.cfg_output_path = argv[argi];
@@ -151,7 +249,8 @@ auto main(i32 argc, const char** argv) -> i32 {
 		return 1;
 	}
 
-	const utility::filepath source_path = argv[argi++];
+	const utility::filepath source_path = argv[argi];
+	source_file source;
 
 	// source file doesn't exist
 	if(!utility::file::exists(source_path)) {
@@ -159,7 +258,12 @@ auto main(i32 argc, const char** argv) -> i32 {
 		return 1;
 	}
 
-	args.source = utility::file::read(source_path);
+	if(!source.open(argv[argi++])) {
+		utility::console::print_err("error: unable to read input file '{}'\n", source_path);
+		return 1;
+	}
+
+	args.source = source.get_view();
 
 	// not all arguments have been processed
 	if(argi < argc) {
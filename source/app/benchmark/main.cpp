@@ -0,0 +1,772 @@
+#include <utility/containers/set.h>
+#include <utility/system/file.h>
+
+#include <assembler/frontend.h>
+#include <assembler/backend.h>
+#include <assembler/builder.h>
+#include <assembler/decoder.h>
+#include <assembler/lexer.h>
+
+#include <assembler/passes/cfg_analyze_pass.h>
+#include <assembler/passes/inst_size_minimize_pass.h>
+#include <assembler/passes/symbolic_minimize_pass.h>
+#include <assembler/passes/emit/emit_binary_pass.h>
+
+using namespace utility::types;
+
+struct benchmark {
+	const char* name;
+	const char* description;
+	void(*run)();
+};
+
+[[nodiscard]] auto compare_commands(const char* shortform, const char* longform, const char* input) -> bool {
+	return utility::compare_strings(shortform, input) == 0 || utility::compare_strings(longform, input) == 0;
+}
+
+// deterministic pseudo random number generator, used so that every run produces the same source
+[[nodiscard]] auto next_random(u64& state) -> u64 {
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+
+	return state;
+}
+
+// generates a valid source file resembling the output of a code generator (long label names,
+// comments, register heavy instructions and numerical data), roughly 'size' bytes long
+[[nodiscard]] auto generate_source(u64 size) -> utility::dynamic_string {
+	constexpr const char* mnemonics[] = { "mov", "add", "sub", "xor", "cmp", "imul" };
+	constexpr const char* memory_mnemonics[] = { "mov", "add", "sub", "xor", "cmp", "lea" };
+	constexpr const char* registers[] = { "rax", "rcx", "rdx", "rbx", "rsi", "rdi", "r8", "r9", "r10", "r15" };
+	constexpr const char* vector_mnemonics[] = { "vaddps", "vmulps", "vpermt2d" };
+	constexpr const char* vector_widths[] = { "xmm", "ymm", "zmm" };
+
+	utility::dynamic_string source;
+	u64 state = 0x2545F4914F6CDD1D;
+	u64 label_count = 1;
+	u64 data_count = 0;
+
+	source += "bits 64\n";
+	source += "generated_block_label_0_entry:\n";
+
+	while(source.get_size() < size) {
+		switch(next_random(state) % 8) {
+			case 0: source.append("generated_block_label_{}_entry:\n", label_count++); break;
+			case 1: source.append("; generated comment describing block {} and some of its properties\n", label_count); break;
+			case 2: source.append("data_{} dq {}, 0x{}, 0b101, 017\n", data_count++, next_random(state) % 1000, next_random(state) % 0xffff); break;
+			case 3: {
+				source.append(
+					"\t{} {}, {}\n",
+					mnemonics[next_random(state) % 6],
+					registers[next_random(state) % 10],
+					registers[next_random(state) % 10]
+				);
+				break;
+			}
+			case 4: {
+				// lea is the only one which doesn't need an explicit operand size
+				const u64 mnemonic = next_random(state) % 6;
+
+				source.append(
+					"\t{} {}, {}[{} + {} * 8 + 0x{}]\n",
+					memory_mnemonics[mnemonic],
+					registers[next_random(state) % 10],
+					mnemonic == 5 ? "" : "qword ",
+					registers[next_random(state) % 10],
+					registers[next_random(state) % 10],
+					next_random(state) % 0xfff
+				);
+				break;
+			}
+			case 5: {
+				// evex encoded, zero masked vector operation
+				const char* width = vector_widths[next_random(state) % 3];
+
+				source.append(
+					"\t{} {}{}{}, {}{}, {}{} ; vector op\n",
+					vector_mnemonics[next_random(state) % 3],
+					width,
+					next_random(state) % 32,
+					"{k1}{z}",
+					width,
+					next_random(state) % 32,
+					width,
+					next_random(state) % 32
+				);
+				break;
+			}
+			case 6: source.append("\tjmp generated_block_label_{}_entry\n", next_random(state) % label_count); break;
+			case 7: source.append("\tmov qword [rsp + {}], {}\n", next_random(state) % 128, next_random(state) % 0x7fffffff); break;
+		}
+	}
+
+	return source;
+}
+
+// generates a source file which only consists of instructions, with mnemonics which have a lot of
+// variants (mov, add, vpermt2d, ...), roughly 'size' bytes long
+[[nodiscard]] auto generate_instruction_source(u64 size) -> utility::dynamic_string {
+	constexpr const char* mnemonics[] = { "mov", "add", "sub", "and", "or", "xor", "cmp", "adc", "sbb" };
+	constexpr const char* registers[] = { "rax", "rcx", "rdx", "rbx", "rsi", "rdi", "r8", "r9", "r10", "r15" };
+	constexpr const char* small_registers[] = { "eax", "ecx", "r8d", "r9w", "ax", "bl", "sil", "r10b" };
+	constexpr const char* vector_mnemonics[] = { "vpermt2d", "vpermt2q", "vpermi2d", "vaddps", "vpaddd", "vpxord" };
+	constexpr const char* vector_widths[] = { "xmm", "ymm", "zmm" };
+
+	utility::dynamic_string source;
+	u64 state = 0x2545F4914F6CDD1D;
+
+	source += "bits 64\n";
+
+	while(source.get_size() < size) {
+		const char* mnemonic = mnemonics[next_random(state) % 9];
+
+		switch(next_random(state) % 6) {
+			case 0: source.append("{} {}, {}\n", mnemonic, registers[next_random(state) % 10], registers[next_random(state) % 10]); break;
+			case 1: source.append("{} {}, {}\n", mnemonic, small_registers[next_random(state) % 8], next_random(state) % 100); break;
+			case 2: source.append("{} {}, qword [{} + 0x{}]\n", mnemonic, registers[next_random(state) % 10], registers[next_random(state) % 10], next_random(state) % 0xfff); break;
+			case 3: source.append("{} qword [{} + 8], {}\n", mnemonic, registers[next_random(state) % 10], next_random(state) % 0x7fff); break;
+			case 4: source.append("{} {}, {}\n", mnemonic, registers[next_random(state) % 10], next_random(state) % 0x7fffffff); break;
+			case 5: {
+				const char* width = vector_widths[next_random(state) % 3];
+
+				source.append(
+					"{} {}{}{}, {}{}, {}{}\n",
+					vector_mnemonics[next_random(state) % 6],
+					width,
+					next_random(state) % 32,
+					"{k1}{z}",
+					width,
+					next_random(state) % 32,
+					width,
+					next_random(state) % 32
+				);
+				break;
+			}
+		}
+	}
+
+	return source;
+}
+
+void benchmark_lexer() {
+	constexpr u64 source_size = 16 * 1024 * 1024;
+	constexpr u8 iteration_count = 5;
+
+	const utility::dynamic_string source = generate_source(source_size);
+	utility::timer timer;
+	u64 token_count = 0;
+
+	timer.start();
+
+	for(u8 i = 0; i < iteration_count; ++i) {
+		baremetal::assembler::lexer lexer(source);
+
+		while(true) {
+			const auto result = lexer.get_next_token();
+
+			if(result.has_error()) {
+				utility::console::print_err("error: {}\n", result.get_error());
+				return;
+			}
+
+			token_count++;
+
+			if(lexer.current == baremetal::assembler::TOK_EOF) {
+				break;
+			}
+		}
+	}
+
+	timer.stop();
+
+	const f64 elapsed = timer.get_elapsed_s();
+
+	utility::console::print(
+		"lexer: {} tokens in {}s ({} Mtok/s, {} MB/s)\n",
+		token_count,
+		elapsed,
+		static_cast<f64>(token_count) / elapsed / 1e6,
+		static_cast<f64>(source.get_size() * iteration_count) / elapsed / (1024.0 * 1024.0)
+	);
+}
+
+void run_frontend_benchmark(const char* name, u64 chunk_count) {
+	constexpr u64 source_size = 4 * 1024 * 1024;
+	constexpr u8 iteration_count = 3;
+
+	const utility::dynamic_string source = generate_source(source_size);
+	utility::timer timer;
+	u64 block_count = 0;
+
+	baremetal::assembler::selection_cache_stats stats = {};
+
+	timer.start();
+
+	for(u8 i = 0; i < iteration_count; ++i) {
+		baremetal::assembler::frontend frontend(source);
+		const auto result = frontend.parse_parallel(chunk_count);
+
+		if(result.has_error()) {
+			utility::console::print_err("error: {}\n", result.get_error());
+			return;
+		}
+
+		block_count += result.get_value().get_block_count();
+		stats.hits += frontend.get_selection_cache_stats().hits;
+		stats.misses += frontend.get_selection_cache_stats().misses;
+	}
+
+	timer.stop();
+
+	const f64 elapsed = timer.get_elapsed_s();
+
+	utility::console::print(
+		"{}: {} blocks in {}s ({} MB/s, {} selection cache hits, {} misses)\n",
+		name,
+		block_count,
+		elapsed,
+		static_cast<f64>(source.get_size() * iteration_count) / elapsed / (1024.0 * 1024.0),
+		stats.hits,
+		stats.misses
+	);
+}
+
+void benchmark_instructions() {
+	constexpr u64 source_size = 4 * 1024 * 1024;
+	constexpr u8 iteration_count = 3;
+
+	const utility::dynamic_string source = generate_instruction_source(source_size);
+	utility::timer timer;
+	u64 line_count = 0;
+
+	// every line, except for the 'bits' directive, is an instruction
+	for(u64 i = 0; i < source.get_size(); ++i) {
+		line_count += source[i] == '\n';
+	}
+
+	const u64 instruction_count = (line_count - 1) * iteration_count;
+
+	baremetal::assembler::selection_cache_stats stats = {};
+
+	timer.start();
+
+	for(u8 i = 0; i < iteration_count; ++i) {
+		baremetal::assembler::frontend frontend(source);
+		const auto result = frontend.parse();
+
+		if(result.has_error()) {
+			utility::console::print_err("error: {}\n", result.get_error());
+			return;
+		}
+
+		stats.hits += frontend.get_selection_cache_stats().hits;
+		stats.misses += frontend.get_selection_cache_stats().misses;
+	}
+
+	timer.stop();
+
+	const f64 elapsed = timer.get_elapsed_s();
+
+	utility::console::print(
+		"instructions: {} instructions in {}s ({} Minst/s, {} MB/s, {} selection cache hits, {} misses)\n",
+		instruction_count,
+		elapsed,
+		static_cast<f64>(instruction_count) / elapsed / 1e6,
+		static_cast<f64>(source.get_size() * iteration_count) / elapsed / (1024.0 * 1024.0),
+		stats.hits,
+		stats.misses
+	);
+}
+
+// collects every instruction of the encoding test corpus
+[[nodiscard]] auto collect_encoding_corpus(utility::dynamic_array<baremetal::assembler::unpacked_instruction>& instructions) -> bool {
+	using namespace baremetal::assembler;
+
+	const utility::filepath corpus_path = "./tests/encoding";
+
+	if(!utility::directory::exists(corpus_path)) {
+		utility::console::print_err("error: cannot find the encoding corpus ('{}')\n", corpus_path);
+		return false;
+	}
+
+	for(const auto& path : utility::directory::read(corpus_path)) {
+		const utility::dynamic_string source = utility::file::read(path);
+
+		if(source.find("skip") != utility::dynamic_string::invalid_pos) {
+			continue;
+		}
+
+		frontend frontend(source);
+		const auto result = frontend.parse();
+
+		if(result.has_error()) {
+			continue;
+		}
+
+		const module& module = result.get_value();
+
+		for(const section& section : module.sections) {
+			for(const basic_block* block : section.blocks) {
+				if(!block->is_instruction_block()) {
+					continue;
+				}
+
+				for(u64 i = 0; i < block->instructions.size; ++i) {
+					const instruction_data& data = block->instructions.data[i];
+					unpacked_instruction inst;
+
+					inst.index = data.index;
+					inst.size = data.size;
+					module.unpack_operands(block, data, inst.operands);
+
+					instructions.push_back(inst);
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+void benchmark_encoder() {
+	using namespace baremetal::assembler;
+
+	constexpr u8 iteration_count = 20;
+
+	utility::dynamic_array<unpacked_instruction> instructions;
+	utility::timer timer;
+	u64 byte_count = 0;
+
+	if(!collect_encoding_corpus(instructions)) {
+		return;
+	}
+
+	u8 output[MAX_INSTRUCTION_SIZE];
+
+	timer.start();
+
+	for(u8 i = 0; i < iteration_count; ++i) {
+		for(const unpacked_instruction& inst : instructions) {
+			byte_count += backend::emit_instruction(&INSTRUCTION_DB[inst.index], inst.operands, output);
+		}
+	}
+
+	timer.stop();
+
+	const f64 elapsed = timer.get_elapsed_s();
+	const u64 instruction_count = instructions.get_size() * iteration_count;
+
+	utility::console::print(
+		"encoder: {} instructions in {}s ({} Minst/s, {} MB/s)\n",
+		instruction_count,
+		elapsed,
+		static_cast<f64>(instruction_count) / elapsed / 1e6,
+		static_cast<f64>(byte_count) / elapsed / (1024.0 * 1024.0)
+	);
+}
+
+void benchmark_decoder() {
+	using namespace baremetal::assembler;
+
+	constexpr u8 iteration_count = 20;
+
+	utility::dynamic_array<unpacked_instruction> instructions;
+	utility::dynamic_array<u8> bytes;
+	utility::timer timer;
+	u64 instruction_count = 0;
+
+	if(!collect_encoding_corpus(instructions)) {
+		return;
+	}
+
+	// encode the whole corpus into a single buffer
+	for(const unpacked_instruction& inst : instructions) {
+		u8 output[MAX_INSTRUCTION_SIZE];
+		const u8 size = backend::emit_instruction(&INSTRUCTION_DB[inst.index], inst.operands, output);
+
+		for(u8 i = 0; i < size; ++i) {
+			bytes.push_back(output[i]);
+		}
+	}
+
+	timer.start();
+
+	for(u8 i = 0; i < iteration_count; ++i) {
+		decoder decoder(bytes.get_data(), bytes.get_size());
+		unpacked_instruction inst;
+
+		while(decoder.decode(inst) != 0) {
+			instruction_count++;
+		}
+
+		if(decoder.get_position() != bytes.get_size()) {
+			utility::console::print_err("error: cannot decode the instruction at offset {}\n", decoder.get_position());
+			return;
+		}
+	}
+
+	timer.stop();
+
+	const f64 elapsed = timer.get_elapsed_s();
+
+	utility::console::print(
+		"decoder: {} instructions in {}s ({} Minst/s, {} MB/s)\n",
+		instruction_count,
+		elapsed,
+		static_cast<f64>(instruction_count) / elapsed / 1e6,
+		static_cast<f64>(bytes.get_size() * iteration_count) / elapsed / (1024.0 * 1024.0)
+	);
+}
+
+// generates the program built by build_program as assembly text
+[[nodiscard]] auto generate_program_source(u64 block_count) -> utility::dynamic_string {
+	using namespace baremetal::assembler;
+
+	utility::dynamic_string source;
+
+	for(u64 i = 0; i < block_count; ++i) {
+		const char* a = g_gpr64_names[i % 16];
+		const char* b = g_gpr64_names[(i + 5) % 16];
+
+		source.append("l{}:\n", i);
+		source.append("mov {}, qword [rsp + {}]\n", a, (i * 8) & 0x7f8);
+		source.append("add {}, {}\n", a, b);
+		source.append("sub {}, {}\n", b, i & 0x3ff);
+		source.append("jnz l{}\n", i);
+	}
+
+	return source;
+}
+
+[[nodiscard]] auto build_program(baremetal::assembler::builder& builder, u64 block_count) -> utility::result<void> {
+	using namespace baremetal::assembler;
+
+	for(u64 i = 0; i < block_count; ++i) {
+		const reg64 a(static_cast<u8>(i % 16));
+		const reg64 b(static_cast<u8>((i + 5) % 16));
+		const label block = builder.create_label();
+
+		TRY(builder.bind(block));
+		TRY(builder.mov(a, m64(ptr(reg64(rsp), static_cast<i32>((i * 8) & 0x7f8)))));
+		TRY(builder.add(a, b));
+		TRY(builder.sub(b, i & 0x3ff));
+		TRY(builder.jnz(block));
+	}
+
+	return SUCCESS;
+}
+
+void benchmark_builder() {
+	using namespace baremetal::assembler;
+
+	constexpr u64 block_count = 100000;
+	constexpr u64 instruction_count = block_count * 4;
+
+	utility::timer timer;
+
+	// print the program and parse it back
+	timer.start();
+
+	const utility::dynamic_string source = generate_program_source(block_count);
+	frontend frontend(source);
+	const auto text_result = frontend.parse();
+
+	timer.stop();
+
+	const f64 text_elapsed = timer.get_elapsed_s();
+
+	// build the same program directly
+	timer.start();
+
+	builder builder;
+	const auto build_result = build_program(builder, block_count);
+	const auto builder_result = builder.finish();
+
+	timer.stop();
+
+	const f64 builder_elapsed = timer.get_elapsed_s();
+
+	if(text_result.has_error() || build_result.has_error() || builder_result.has_error()) {
+		utility::console::print_err("error: cannot assemble the generated program\n");
+		return;
+	}
+
+	const utility::dynamic_array<u8> text_binary = pass::emit_binary(text_result.get_value());
+	const utility::dynamic_array<u8> builder_binary = pass::emit_binary(builder_result.get_value());
+	bool identical = text_binary.get_size() == builder_binary.get_size();
+
+	for(u64 i = 0; identical && i < text_binary.get_size(); ++i) {
+		identical = text_binary[i] == builder_binary[i];
+	}
+
+	if(!identical) {
+		utility::console::print_err("error: the builder and the frontend produced different programs\n");
+		return;
+	}
+
+	utility::console::print(
+		"builder: {} instructions in {}s ({} Minst/s), through text: {}s ({} Minst/s)\n",
+		instruction_count,
+		builder_elapsed,
+		static_cast<f64>(instruction_count) / builder_elapsed / 1e6,
+		text_elapsed,
+		static_cast<f64>(instruction_count) / text_elapsed / 1e6
+	);
+}
+
+void benchmark_emit() {
+	using namespace baremetal::assembler;
+
+	constexpr u64 source_size = 4 * 1024 * 1024;
+	constexpr u8 iteration_count = 10;
+
+	const utility::dynamic_string source = generate_instruction_source(source_size);
+	frontend frontend(source);
+	auto result = frontend.parse();
+
+	if(result.has_error()) {
+		utility::console::print_err("error: {}\n", result.get_error());
+		return;
+	}
+
+	module& module = result.get_value();
+
+	pass::cfg_analyze(module);
+	pass::inst_size_minimize(module);
+	pass::symbolic_minimize(module);
+
+	u64 instruction_count = 0;
+	u64 encoded_count = 0;
+
+	for(const section& section : module.sections) {
+		for(const basic_block* block : section.blocks) {
+			if(!block->is_instruction_block()) {
+				continue;
+			}
+
+			for(u64 i = 0; i < block->instructions.size; ++i) {
+				encoded_count += block->instructions.data[i].encoded != instruction_data::NOT_ENCODED;
+			}
+
+			instruction_count += block->instructions.size;
+		}
+	}
+
+	utility::dynamic_array<u8> output;
+	utility::timer timer;
+
+	output.resize(pass::get_binary_size(module));
+	timer.start();
+
+	for(u8 i = 0; i < iteration_count; ++i) {
+		pass::emit_binary(module, output.get_data());
+	}
+
+	timer.stop();
+
+	const f64 elapsed = timer.get_elapsed_s();
+
+	utility::console::print(
+		"emit: {} instructions in {}s ({} Minst/s, {} encoded ahead of time)\n",
+		instruction_count * iteration_count,
+		elapsed,
+		static_cast<f64>(instruction_count * iteration_count) / elapsed / 1e6,
+		encoded_count
+	);
+}
+
+void benchmark_cfg() {
+	using namespace baremetal::assembler;
+
+	constexpr u64 section_count = 10000;
+	constexpr u64 branch_count = 4; // per section
+
+	// many small sections, every one of them containing a few loops
+	builder builder;
+
+	for(u64 i = 0; i < section_count; ++i) {
+		utility::dynamic_string name;
+		name.append(".s{}", i);
+
+		builder.set_section(utility::string_view(name.get_data(), name.get_size()));
+
+		for(u64 j = 0; j < branch_count; ++j) {
+			const label block = builder.create_label();
+
+			if(builder.bind(block).has_error() || builder.add(reg64(0), reg64(3)).has_error() || builder.jnz(block).has_error()) {
+				utility::console::print_err("error: cannot build the program\n");
+				return;
+			}
+		}
+	}
+
+	auto result = builder.finish();
+
+	if(result.has_error()) {
+		utility::console::print_err("error: {}\n", result.get_error());
+		return;
+	}
+
+	module& module = result.get_value();
+	utility::timer timer;
+
+	timer.start();
+	pass::cfg_analyze(module);
+	timer.stop();
+
+	const f64 elapsed = timer.get_elapsed_s();
+
+	utility::console::print(
+		"cfg: {} blocks in {} sections in {}s ({} Mblocks/s)\n",
+		module.get_block_count(),
+		section_count,
+		elapsed,
+		static_cast<f64>(module.get_block_count()) / elapsed / 1e6
+	);
+}
+
+// builds a program with 'branch_count' conditional branches, every one of them jumping up to 48 blocks
+// back or forth, hence roughly half of them need a rel32 displacement
+[[nodiscard]] auto build_branch_program(baremetal::assembler::builder& builder, u64 branch_count) -> utility::result<void> {
+	using namespace baremetal::assembler;
+
+	utility::dynamic_array<label> labels;
+	u64 state = 0x2545F4914F6CDD1D;
+
+	for(u64 i = 0; i < branch_count; ++i) {
+		labels.push_back(builder.create_label());
+	}
+
+	for(u64 i = 0; i < branch_count; ++i) {
+		const u64 target = i + next_random(state) % 97;
+
+		// clamp the target to the program
+		const u64 clamped = target < 48 ? 0 : target - 48 >= branch_count ? branch_count - 1 : target - 48;
+
+		TRY(builder.bind(labels[i]));
+		TRY(builder.add(reg64(0), reg64(3)));
+		TRY(builder.jnz(labels[clamped]));
+	}
+
+	return SUCCESS;
+}
+
+void benchmark_relaxation() {
+	using namespace baremetal::assembler;
+
+	constexpr u64 branch_counts[] = { 100000, 250000, 500000, 1000000 };
+
+	for(const u64 branch_count : branch_counts) {
+		builder builder;
+
+		if(build_branch_program(builder, branch_count).has_error()) {
+			utility::console::print_err("error: cannot build the program\n");
+			return;
+		}
+
+		auto result = builder.finish();
+
+		if(result.has_error()) {
+			utility::console::print_err("error: {}\n", result.get_error());
+			return;
+		}
+
+		module& module = result.get_value();
+		utility::timer timer;
+
+		timer.start();
+		pass::symbolic_minimize(module);
+		timer.stop();
+
+		const f64 elapsed = timer.get_elapsed_s();
+
+		utility::console::print(
+			"relaxation: {} branches in {}s ({} ns/branch, {} B)\n",
+			branch_count,
+			elapsed,
+			elapsed * 1e9 / static_cast<f64>(branch_count),
+			pass::get_binary_size(module)
+		);
+	}
+}
+
+void benchmark_frontend() {
+	run_frontend_benchmark("frontend", 1);
+}
+
+void benchmark_frontend_parallel() {
+	run_frontend_benchmark("frontend_parallel", 4);
+}
+
+constexpr benchmark g_benchmarks[] = {
+	{ "lexer",             "tokenizes a generated 16MB source file",                 benchmark_lexer             },
+	{ "frontend",          "parses a generated 4MB source file",                     benchmark_frontend          },
+	{ "frontend_parallel", "parses a generated 4MB source file split into 4 chunks", benchmark_frontend_parallel },
+	{ "instructions",      "parses a generated 4MB source file of instructions only", benchmark_instructions      },
+	{ "encoder",           "encodes every instruction of the encoding test corpus",   benchmark_encoder           },
+	{ "decoder",           "decodes every instruction of the encoding test corpus",   benchmark_decoder           },
+	{ "builder",           "builds a program through the builder and through text",    benchmark_builder           },
+	{ "emit",              "emits an optimized 4MB source file of instructions",       benchmark_emit              },
+	{ "cfg",               "analyzes the control flow of 10000 small sections",        benchmark_cfg               },
+	{ "relaxation",        "relaxes programs with 100000 to 1000000 branches",         benchmark_relaxation        },
+};
+
+void display_help() {
+	utility::console::print(
+		"usage: benchmark [-l|-h|-v|<benchmark_names...>]\n"
+		"  -v --version    print the benchmark runner version number\n"
+		"  -l --list       list all available benchmarks\n"
+		"  -h --help       display this help message\n"
+		"\n"
+		"for bug reports and issues, please see:\n"
+		"<https://github.com/Goubermouche/baremetal/issues>\n"
+	);
+}
+
+void display_version() {
+	utility::console::print("benchmark runner version {} compiled on {}\n", VERSION, __DATE__);
+}
+
+void list_benchmarks() {
+	for(const benchmark& b : g_benchmarks) {
+		utility::console::print("{}: {}\n", b.name, b.description);
+	}
+}
+
+auto main(i32 argc, const char** argv) -> i32 {
+	utility::set<utility::dynamic_string> names;
+
+	if(argc == 1) {
+		// run everything
+		for(const benchmark& b : g_benchmarks) {
+			b.run();
+		}
+
+		return 0;
+	}
+	else if(compare_commands("-h", "--help", argv[1])) {
+		display_help();
+		return 0;
+	}
+	else if(compare_commands("-v", "--version", argv[1])) {
+		display_version();
+		return 0;
+	}
+	else if(compare_commands("-l", "--list", argv[1])) {
+		list_benchmarks();
+		return 0;
+	}
+
+	for(i32 i = 1; i < argc; ++i) {
+		names.insert(argv[i]);
+	}
+
+	for(const benchmark& b : g_benchmarks) {
+		if(names.contains(b.name)) {
+			b.run();
+		}
+	}
+
+	return 0;
+}
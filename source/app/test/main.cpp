@@ -3,6 +3,10 @@
 #include <utility/system/file.h>
 
 #include <assembler/frontend.h>
+#include <assembler/backend.h>
+#include <assembler/builder.h>
+#include <assembler/decoder.h>
+#include <assembler/jit.h>
 
 // assembler passes
 // optimization
@@ -16,6 +20,7 @@
 #include <assembler/passes/emit/emit_cfg_pass.h>
 
 const utility::filepath g_test_path = "./tests";
+baremetal::assembler::jit g_jit; // shared by all tests, so that code regions get reused
 
 using namespace utility::types;
 
@@ -40,6 +45,434 @@ enum test_result : u8 {
 	return groups;
 }
 
+// verifies that the size-only encoding path agrees with the actual encoder for every instruction
+[[nodiscard]] auto verify_instruction_sizes(const baremetal::assembler::module& module) -> utility::result<void> {
+	using namespace baremetal::assembler;
+
+	for(const section& section : module.sections) {
+		for(const basic_block* block : section.blocks) {
+			if(!block->is_instruction_block()) {
+				continue;
+			}
+
+			for(u64 i = 0; i < block->instructions.size; ++i) {
+				const instruction_data& inst = block->instructions.data[i];
+				u8 encoded[MAX_INSTRUCTION_SIZE];
+				operand operands[4];
+
+				module.unpack_operands(block, inst, operands);
+
+				const u8 computed = backend::compute_size(&INSTRUCTION_DB[inst.index], operands);
+				const u8 emitted = backend::emit_instruction(&INSTRUCTION_DB[inst.index], operands, encoded);
+
+				if(computed != emitted) {
+					utility::console::print_err("'{}': computed size {} differs from the encoded size {}\n", INSTRUCTION_DB[inst.index].name, computed, emitted);
+					return utility::error("instruction size mismatch");
+				}
+			}
+		}
+	}
+
+	return SUCCESS;
+}
+
+// verifies that every instruction decodes back into a variant which encodes into the same bytes
+[[nodiscard]] auto verify_decoder(const baremetal::assembler::module& module) -> utility::result<void> {
+	using namespace baremetal::assembler;
+
+	for(const section& section : module.sections) {
+		for(const basic_block* block : section.blocks) {
+			if(!block->is_instruction_block()) {
+				continue;
+			}
+
+			for(u64 i = 0; i < block->instructions.size; ++i) {
+				const instruction_data& inst = block->instructions.data[i];
+				u8 encoded[MAX_INSTRUCTION_SIZE];
+				u8 reencoded[MAX_INSTRUCTION_SIZE];
+				operand operands[4];
+
+				module.unpack_operands(block, inst, operands);
+
+				const u8 size = backend::emit_instruction(&INSTRUCTION_DB[inst.index], operands, encoded);
+
+				decoder decoder(encoded, size);
+				unpacked_instruction decoded;
+
+				if(decoder.decode(decoded) != size) {
+					utility::console::print_err("'{}': cannot decode the encoded instruction\n", INSTRUCTION_DB[inst.index].name);
+					return utility::error("instruction decoding mismatch");
+				}
+
+				backend::emit_instruction(&INSTRUCTION_DB[decoded.index], decoded.operands, reencoded);
+
+				for(u8 j = 0; j < size; ++j) {
+					if(encoded[j] != reencoded[j]) {
+						utility::console::print_err("'{}': decoded as '{}', which encodes differently\n", INSTRUCTION_DB[inst.index].name, INSTRUCTION_DB[decoded.index].name);
+						return utility::error("instruction decoding mismatch");
+					}
+				}
+			}
+		}
+	}
+
+	return SUCCESS;
+}
+
+// assembles the given source and returns the hex encoding of the resulting binary
+[[nodiscard]] auto assemble(const utility::dynamic_string& source, u64 chunk_count) -> utility::result<utility::dynamic_string> {
+	baremetal::assembler::frontend assembler(source);
+	TRY(auto module, assembler.parse_parallel(chunk_count));
+
+	// optimize the resulting module
+	baremetal::assembler::pass::cfg_analyze(module);
+	baremetal::assembler::pass::inst_size_minimize(module);
+	baremetal::assembler::pass::symbolic_minimize(module);
+	TRY(verify_instruction_sizes(module));
+	TRY(verify_decoder(module));
+
+	const utility::dynamic_array<u8> output = baremetal::assembler::pass::emit_binary(module);
+	return utility::bytes_to_string(output, output.get_size());
+}
+
+// assembles the given source into executable memory and returns the hex encoding of the code
+[[nodiscard]] auto assemble_jit(const utility::dynamic_string& source) -> utility::result<utility::dynamic_string> {
+	TRY(auto code, g_jit.assemble(utility::string_view(source.get_data(), source.get_size())));
+
+	utility::dynamic_array<u8> bytes;
+	bytes.insert(bytes.end(), code.data, code.data + code.size);
+
+	// absolute references have been relocated to the address of the code, undo this so that we can
+	// compare the code against the flat binary
+	for(const u64 offset : code.relocations) {
+		u64 address;
+
+		utility::memcpy(&address, bytes.get_data() + offset, sizeof(u64));
+		address -= reinterpret_cast<u64>(code.data);
+		utility::memcpy(bytes.get_data() + offset, &address, sizeof(u64));
+	}
+
+	g_jit.release(code);
+
+	return utility::bytes_to_string(bytes, bytes.get_size());
+}
+
+// the tests only compare the emitted bytes, make sure that the code the jit hands out actually runs
+[[nodiscard]] auto run_jit_execution_test() -> test_result {
+	// plain function
+	auto result = g_jit.assemble("global f\nf:\n\tmov eax, 42\n\tret\n");
+
+	if(result.has_error()) {
+		utility::console::print_err("error: {} (jit execution)\n", result.get_error());
+		return RES_FAIL;
+	}
+
+	baremetal::assembler::jit_code code = result.get_value();
+	const i32 value = code.get_function<i32(*)()>("f")();
+	g_jit.release(code);
+
+	if(value != 42) {
+		utility::console::print_err("mismatch: jit execution - expected 42, but got {}\n", value);
+		return RES_FAIL;
+	}
+
+	// the address of a label has to point into the code
+	result = g_jit.assemble("global g\nglobal x\ng:\n\tmov rax, x\n\tret\nx dq 5\n");
+
+	if(result.has_error()) {
+		utility::console::print_err("error: {} (jit execution)\n", result.get_error());
+		return RES_FAIL;
+	}
+
+	code = result.get_value();
+	const u64* address = code.get_function<u64*(*)()>("g")();
+	const bool valid = address == code.get_symbol("x") && *address == 5;
+	g_jit.release(code);
+
+	if(!valid) {
+		utility::console::print_err("mismatch: jit execution - label address doesn't point into the code\n");
+		return RES_FAIL;
+	}
+
+	// absolute references which can't hold an address are rejected
+	if(!g_jit.assemble("g:\n\tmov eax, x\n\tret\nx dq 5\n").has_error()) {
+		utility::console::print_err("mismatch: jit execution - expected a 32-bit absolute reference to be rejected\n");
+		return RES_FAIL;
+	}
+
+	if(!g_jit.assemble("g:\n\tmov qword [x], 1\n\tret\nx dq 5\n").has_error()) {
+		utility::console::print_err("mismatch: jit execution - expected a symbolic memory displacement to be rejected\n");
+		return RES_FAIL;
+	}
+
+	return RES_PASS;
+}
+
+// optimizes the module the same way the text path does, and emits it into a flat binary
+[[nodiscard]] auto emit_module(baremetal::assembler::module& module) -> utility::dynamic_array<u8> {
+	baremetal::assembler::pass::cfg_analyze(module);
+	baremetal::assembler::pass::inst_size_minimize(module);
+	baremetal::assembler::pass::symbolic_minimize(module);
+
+	return baremetal::assembler::pass::emit_binary(module);
+}
+
+[[nodiscard]] auto build_module(baremetal::assembler::builder& builder) -> utility::result<void> {
+	using namespace baremetal::assembler;
+
+	const label start = builder.create_label("start");
+	const label loop = builder.create_label("loop");
+	const label value = builder.create_label("value");
+	constexpr u8 bytes[] = { 1, 2, 3, 4 };
+
+	builder.global(start);
+
+	TRY(builder.bind(start));
+	TRY(builder.mov(reg64(rax), m64(ptr(reg64(rsp), 8))));
+	TRY(builder.add(reg64(rax), reg64(rcx)));
+	TRY(builder.mov(reg32(ecx), 0x1234));
+	TRY(builder.mov(reg32(2), m32(ptr(reg64(6), reg64(7), SCALE_4, -16)))); // edx, rsi, rdi
+	TRY(builder.bind(loop));
+	TRY(builder.sub(reg64(rcx), 1));
+	TRY(builder.jnz(loop));
+	TRY(builder.mov(reg64(rax), value));
+	TRY(builder.ret());
+
+	builder.set_section(".data");
+
+	TRY(builder.bind(value));
+	builder.data(bytes, sizeof(bytes));
+
+	return SUCCESS;
+}
+
+// the builder has to produce the same module as the frontend does for the equivalent source
+[[nodiscard]] auto run_builder_test() -> test_result {
+	using namespace baremetal::assembler;
+
+	const utility::dynamic_string source =
+		"global start\n"
+		"start:\n"
+		"\tmov rax, qword [rsp + 8]\n"
+		"\tadd rax, rcx\n"
+		"\tmov ecx, 0x1234\n"
+		"\tmov edx, dword [rsi + rdi * 4 - 16]\n"
+		"loop:\n"
+		"\tsub rcx, 1\n"
+		"\tjnz loop\n"
+		"\tmov rax, value\n"
+		"\tret\n"
+		"section .data\n"
+		"value db 1, 2, 3, 4\n";
+
+	frontend frontend(source);
+	auto text_result = frontend.parse();
+
+	builder builder;
+	const auto build_result = build_module(builder);
+	auto builder_result = builder.finish();
+
+	if(text_result.has_error() || build_result.has_error() || builder_result.has_error()) {
+		utility::console::print_err("error: cannot assemble the builder test program\n");
+		return RES_FAIL;
+	}
+
+	module& text_module = text_result.get_value();
+	module& builder_module = builder_result.get_value();
+
+	const utility::dynamic_array<u8> text_binary = emit_module(text_module);
+	const utility::dynamic_array<u8> builder_binary = emit_module(builder_module);
+
+	const utility::dynamic_string expected = utility::bytes_to_string(text_binary, text_binary.get_size());
+	const utility::dynamic_string actual = utility::bytes_to_string(builder_binary, builder_binary.get_size());
+
+	if(actual != expected) {
+		utility::console::print_err("mismatch: builder - expected '{}', but got '{}'\n", expected, actual);
+		return RES_FAIL;
+	}
+
+	// globals
+	if(text_module.globals.get_size() != 1 || builder_module.globals.get_size() != 1 || *builder_module.globals[0] != "start") {
+		utility::console::print_err("mismatch: builder - global symbols differ\n");
+		return RES_FAIL;
+	}
+
+	const symbol_data* text_symbol = text_module.find_symbol(text_module.globals[0]);
+	const symbol_data* builder_symbol = builder_module.find_symbol(builder_module.globals[0]);
+
+	if(
+		text_symbol == nullptr || builder_symbol == nullptr ||
+		text_module.get_global_symbol_position(*text_symbol) != builder_module.get_global_symbol_position(*builder_symbol)
+	) {
+		utility::console::print_err("mismatch: builder - global symbol positions differ\n");
+		return RES_FAIL;
+	}
+
+	// every label has to be bound before the module is finished
+	baremetal::assembler::builder unbound;
+	const label target = unbound.create_label("target");
+
+	if(unbound.jmp(target).has_error() || !unbound.finish().has_error()) {
+		utility::console::print_err("mismatch: builder - expected an unbound label to be rejected\n");
+		return RES_FAIL;
+	}
+
+	return RES_PASS;
+}
+
+// builder argument for an operand of the specified type, 'value' picks the register index (the
+// third value picks an EVEX only vector register) or the immediate, relocations are labels
+template<baremetal::assembler::operand_type type>
+[[nodiscard]] auto get_sweep_operand(u8 value, baremetal::assembler::label target) {
+	using namespace baremetal::assembler;
+
+	const u8 index = value;
+	const u8 vector_index = value == 2 ? 17 : value;
+
+	if constexpr(type == OP_R8 || type == OP_AL || type == OP_CL) { return reg8(index); }
+	else if constexpr(type == OP_R16 || type == OP_AX || type == OP_DX) { return reg16(index); }
+	else if constexpr(type == OP_R32 || type == OP_EAX || type == OP_ECX) { return reg32(index); }
+	else if constexpr(type == OP_R64 || type == OP_RAX || type == OP_RCX) { return reg64(index); }
+	else if constexpr(type == OP_XMM) { return xmm(vector_index); }
+	else if constexpr(type == OP_YMM) { return ymm(vector_index); }
+	else if constexpr(type == OP_ZMM) { return zmm(vector_index, REG_ZMM); }
+	else if constexpr(type == OP_K) { return kreg(index); }
+	else if constexpr(type == OP_FS) { return sreg(fs); }
+	else if constexpr(type == OP_GS) { return sreg(gs); }
+	else if constexpr(type == OP_SREG) { return sreg(index); }
+	else if constexpr(type == OP_ST || type == OP_ST0) { return st(index); }
+	else if constexpr(type == OP_TMM) { return tmm(index); }
+	else if constexpr(type == OP_MMX) { return mmx(index); }
+	else if constexpr(type == OP_DREG) { return dreg(index); }
+	else if constexpr(type == OP_CREG) { return creg(index); }
+	else if constexpr(type == OP_BND) { return bnd(index); }
+	else if constexpr(is_operand_imm(type)) { return value == 2 ? 0x12345678 : 1; }
+	else { return target; }
+}
+
+template<baremetal::assembler::operand_type type>
+constexpr auto is_sweep_operand() -> bool {
+	using namespace baremetal::assembler;
+
+	if constexpr(is_operand_imm(type) || is_operand_rel(type)) {
+		return true;
+	}
+	else {
+		return !std::is_same_v<decltype(get_sweep_operand<type>(0, label())), label>;
+	}
+}
+
+template<u32 index, u64... i>
+constexpr auto is_sweep_variant(std::index_sequence<i...>) -> bool {
+	return (is_sweep_operand<baremetal::assembler::INSTRUCTION_DB[index].operands[i]>() && ...);
+}
+
+template<u32 index, u64... i>
+void sweep_variant(baremetal::assembler::builder (&builders)[2], const baremetal::assembler::label (&targets)[2], u8 value, u64& mismatch_count, std::index_sequence<i...>) {
+	using namespace baremetal::assembler;
+
+	constexpr const instruction& inst = INSTRUCTION_DB[index];
+
+	const auto selected = builders[0].emit<inst.mnemonic>(get_sweep_operand<inst.operands[i]>(value, targets[0])...);
+	const auto runtime = builders[1].emit(inst.mnemonic, get_sweep_operand<inst.operands[i]>(value, targets[1])...);
+
+	if(selected.has_error() != runtime.has_error()) {
+		utility::console::print_err("mismatch: builder selection - '{}' (variant {})\n", inst.name, index);
+		mismatch_count++;
+	}
+}
+
+// emits the variant with every kind of operand value through the compile time selection, and
+// through the runtime one, both have to accept the same operands
+template<u32 index>
+void sweep_variant(baremetal::assembler::builder (&builders)[2], const baremetal::assembler::label (&targets)[2], u64& mismatch_count) {
+	using namespace baremetal::assembler;
+
+	constexpr auto operands = std::make_index_sequence<INSTRUCTION_DB[index].operand_count>();
+
+	if constexpr(is_sweep_variant<index>(operands)) {
+		for(u8 value = 0; value < 3; ++value) {
+			sweep_variant<index>(builders, targets, value, mismatch_count, operands);
+		}
+	}
+}
+
+template<u32 base, u64... offsets>
+void sweep_variants(baremetal::assembler::builder (&builders)[2], const baremetal::assembler::label (&targets)[2], u64& mismatch_count, std::index_sequence<offsets...>) {
+	([&] {
+		if constexpr(base + offsets < baremetal::assembler::INSTRUCTION_DB_SIZE) {
+			sweep_variant<base + offsets>(builders, targets, mismatch_count);
+		}
+	}(), ...);
+}
+
+template<u64... chunks>
+void sweep_chunks(baremetal::assembler::builder (&builders)[2], const baremetal::assembler::label (&targets)[2], u64& mismatch_count, std::index_sequence<chunks...>) {
+	(sweep_variants<chunks * 256>(builders, targets, mismatch_count, std::make_index_sequence<256>()), ...);
+}
+
+// the builder selects instructions with registers, immediates and labels at compile time, which has
+// to agree with the selection done at runtime for every variant of every mnemonic
+[[nodiscard]] auto run_builder_selection_test() -> test_result {
+	using namespace baremetal::assembler;
+
+	builder builders[2];
+	const label targets[2] = { builders[0].create_label("target"), builders[1].create_label("target") };
+	u64 mismatch_count = 0;
+
+	sweep_chunks(builders, targets, mismatch_count, std::make_index_sequence<(INSTRUCTION_DB_SIZE + 255) / 256>());
+
+	if(mismatch_count != 0) {
+		return RES_FAIL;
+	}
+
+	const bool bound = !builders[0].bind(targets[0]).has_error() && !builders[1].bind(targets[1]).has_error();
+
+	auto selected = builders[0].finish();
+	auto runtime = builders[1].finish();
+
+	if(!bound || selected.has_error() || runtime.has_error()) {
+		utility::console::print_err("error: cannot finish the builder selection modules\n");
+		return RES_FAIL;
+	}
+
+	// both paths have to select the same variants, with the same sizes
+	const module& selected_module = selected.get_value();
+	const module& runtime_module = runtime.get_value();
+	bool identical = selected_module.sections.get_size() == runtime_module.sections.get_size();
+
+	for(u64 i = 0; identical && i < selected_module.sections.get_size(); ++i) {
+		const section& left = selected_module.sections[i];
+		const section& right = runtime_module.sections[i];
+
+		identical = left.blocks.get_size() == right.blocks.get_size();
+
+		for(u64 j = 0; identical && j < left.blocks.get_size(); ++j) {
+			const basic_block* left_block = left.blocks[j];
+			const basic_block* right_block = right.blocks[j];
+
+			if(!left_block->is_instruction_block()) {
+				continue;
+			}
+
+			identical = left_block->instructions.size == right_block->instructions.size;
+
+			for(u64 k = 0; identical && k < left_block->instructions.size; ++k) {
+				identical =
+					left_block->instructions.data[k].index == right_block->instructions.data[k].index &&
+					left_block->instructions.data[k].size == right_block->instructions.data[k].size;
+			}
+		}
+	}
+
+	if(!identical) {
+		utility::console::print_err("mismatch: builder selection - the compile time selection produced a different module\n");
+		return RES_FAIL;
+	}
+
+	return RES_PASS;
+}
+
 [[nodiscard]] auto run_test(const utility::filepath& path) -> test_result {
 	utility::dynamic_string test_text = utility::file::read(path);
 	utility::dynamic_string expected;
@@ -68,31 +501,48 @@ enum test_result : u8 {
 
 	expected = test_text.substring(expected_pos + 1, end_pos - expected_pos - 1);
 
-	// parse the source file
-	baremetal::assembler::frontend assembler(test_text);
-	const auto result = assembler.parse();
+	// assemble the source file serially, and split up into multiple chunks, which are parsed in 
+	// parallel, both have to produce the expected result
+	constexpr u64 chunk_counts[] = { 1, 4 };
 
-	// check for assembly errors
-	if(result.has_error()) {
-		utility::console::print_err("error: {}\n", result.get_error());
-		return RES_FAIL;
+	for(const u64 chunk_count : chunk_counts) {
+		const auto result = assemble(test_text, chunk_count);
+
+		// check for assembly errors
+		if(result.has_error()) {
+			utility::console::print_err("error: {}\n", result.get_error());
+			return RES_FAIL;
+		}
+
+		// compare against the expected hex encoding
+		if(result.get_value() != expected) {
+			utility::console::print_err("mismatch: {} ({} chunks) - expected '{}', but got '{}'\n", path, chunk_count, expected, result.get_value()); 
+			// utility::console::print_err("mismatch: {}\n", path); 
+			return RES_FAIL;
+		}
 	}
 
-	// optimize the resulting module
-	auto module = result.get_value();
+	// the jit has to produce the same code, unless the source contains absolute references which
+	// can't hold the address of the code (see jit.h), these are marked with the 'jit: reject'
+	// directive, and have to be rejected by the jit
+	const auto result = assemble_jit(test_text);
 
-	baremetal::assembler::pass::cfg_analyze(module);
-	baremetal::assembler::pass::inst_size_minimize(module);
-	baremetal::assembler::pass::symbolic_minimize(module);
+	if(test_text.find("jit: reject") != utility::dynamic_string::invalid_pos) {
+		if(result.has_error()) {
+			return RES_PASS;
+		}
 
-	utility::dynamic_array<u8> output = baremetal::assembler::pass::emit_binary(module);
+		utility::console::print_err("mismatch: {} (jit) - expected the absolute references to be rejected\n", path);
+		return RES_FAIL;
+	}
 
-	// compare against the expected hex encoding
-	utility::dynamic_string hex_result = utility::bytes_to_string(output, output.get_size());
+	if(result.has_error()) {
+		utility::console::print_err("error: {} (jit)\n", result.get_error());
+		return RES_FAIL;
+	}
 
-	if(hex_result != expected) {
-		utility::console::print_err("mismatch: {} - expected '{}', but got '{}'\n", path, expected, hex_result); 
-		// utility::console::print_err("mismatch: {}\n", path); 
+	if(result.get_value() != expected) {
+		utility::console::print_err("mismatch: {} (jit) - expected '{}', but got '{}'\n", path, expected, result.get_value());
 		return RES_FAIL;
 	}
 
@@ -125,6 +575,24 @@ enum test_result : u8 {
 		}
 	}
 
+	switch(run_jit_execution_test()) {
+		case RES_PASS: pass_count++; break;
+		case RES_FAIL: fail_count++; break;
+		case RES_SKIP: skip_count++; break;
+	}
+
+	switch(run_builder_test()) {
+		case RES_PASS: pass_count++; break;
+		case RES_FAIL: fail_count++; break;
+		case RES_SKIP: skip_count++; break;
+	}
+
+	switch(run_builder_selection_test()) {
+		case RES_PASS: pass_count++; break;
+		case RES_FAIL: fail_count++; break;
+		case RES_SKIP: skip_count++; break;
+	}
+
 	timer.stop();
 
 	utility::console::print(
@@ -1,5 +1,4 @@
 #include "./backend.h"
-#include <utility/algorithms/sort.h>
 
 namespace baremetal::assembler {
 	namespace detail {
@@ -85,40 +84,55 @@ namespace baremetal::assembler {
 
 			return x;
 		}
-	} // namespace detail
 
-	const instruction* backend::m_inst;
-	const operand* backend::m_operands;
+		auto get_widest_variant(u32 index, u8 operand_index) -> u32 {
+			const instruction_variants variants = get_instruction_variants(index, operand_index);
 
-	u8 backend::m_data_size;
-	u8 backend::m_data[MAX_INSTRUCTION_SIZE];
+			if(variants.count == 0) {
+				return index;
+			}
 
-	auto backend::get_instruction_by_name(const char* name) -> u32 {
-		i32 left = 0;
-		i32 right = INSTRUCTION_DB_SIZE - 1;
-
-		// since our instructions are sorted alphabetically, we can just do a quick binary search
-		while(left <= right) {
-			u32 mid = (static_cast<u32>(left) + static_cast<u32>(right)) >> 1;
-			i32 cmp = utility::compare_strings(name, INSTRUCTION_DB[mid].name);
-
-			if(cmp == 0) {
-				// found an element with the specified name, loccate the first one
-				while(mid > 0 && utility::compare_strings(name, INSTRUCTION_DB[mid - 1].name) == 0) {
-					--mid;
-				}
+			// variants are sorted by width, pick the first one of the widest ones
+			const u16 width = get_operand_bit_width(INSTRUCTION_DB[variants.indices[variants.count - 1]].operands[operand_index]);
+			u8 largest = variants.count - 1;
 
-				return mid;
-			}
-			else if(cmp < 0) {
-				right = static_cast<i32>(mid) - 1;
+			while(largest > 0 && get_operand_bit_width(INSTRUCTION_DB[variants.indices[largest - 1]].operands[operand_index]) == width) {
+				largest--;
 			}
-			else {
-				left = static_cast<i32>(mid) + 1;
+
+			return variants.indices[largest];
+		}
+
+		auto get_immediate_offset(const instruction* inst, u8 operand_index, u8 size) -> u8 {
+			ASSERT(is_operand_imm(inst->operands[operand_index]) || is_operand_rel(inst->operands[operand_index]), "operand is not an immediate\n");
+
+			// immediates are emitted last, in the order of their operands, followed by the /is4 byte
+			u8 trailing = inst->is_is4();
+
+			for(u8 i = operand_index; i < inst->operand_count; ++i) {
+				if(is_operand_imm(inst->operands[i]) || is_operand_rel(inst->operands[i])) {
+					trailing += static_cast<u8>(get_operand_bit_width(inst->operands[i]) / 8);
+				}
 			}
+
+			return size - trailing;
 		}
+	} // namespace detail
+
+	auto backend::get_instruction_by_name(const char* name) -> u32 {
+		u64 size = 0;
+
+		while(name[size] != '\0') {
+			size++;
+		}
+
+		const u16 id = get_mnemonic(name, size);
 
-		return utility::limits<u32>::max();
+		if(id == INVALID_MNEMONIC) {
+			return utility::limits<u32>::max();
+		}
+
+		return get_mnemonic_info(id).first;
 	}
 
 	auto is_legal_operand_variant(operand_type a, operand_type b) -> bool {
@@ -136,7 +150,7 @@ namespace baremetal::assembler {
 		// check if instruction[a] == instruction[b]
 		const u8 operand_count = INSTRUCTION_DB[a].operand_count;
 
-		if(utility::compare_strings(INSTRUCTION_DB[a].name, INSTRUCTION_DB[b].name) != 0) {
+		if(b >= INSTRUCTION_DB_SIZE || INSTRUCTION_DB[a].mnemonic != INSTRUCTION_DB[b].mnemonic) {
 			return false;
 		}
 
@@ -157,35 +171,34 @@ namespace baremetal::assembler {
 	}
 
 	auto backend::get_instruction_direct(u32 index, const operand* operands) -> const instruction* {
-		const instruction& first = INSTRUCTION_DB[index];
+		const mnemonic& info = get_mnemonic_info(INSTRUCTION_DB[index].mnemonic);
+		bool unknown = false;
 		u8 operand_count = 0;
 	
 		for(operand_count = 0; operand_count< 4; ++operand_count) {
-			// we have an unresolved symbol as an operand, pick the biggest possible variant of this instruction
+			// we have an unresolved symbol as an operand, pick the biggest possible variant of this
+			// instruction, symbolic memory operands always use 32-bit displacements, hence their variant
+			// stays the same
 			if(operands[operand_count].unknown) {
-				const instruction* largest_variant = &INSTRUCTION_DB[index];
-				u32 current_index = index + 1;
-				
-				while(is_legal_variant(index, current_index, operand_count)) {
-					const instruction* current = &INSTRUCTION_DB[current_index];
-
-					if(get_operand_bit_width(current->operands[operand_count]) > 
-						get_operand_bit_width(largest_variant->operands[operand_count])) {
-						largest_variant = current;
-					}
-
-					current_index++;
+				if(!is_operand_mem(INSTRUCTION_DB[index].operands[operand_count])) {
+					index = detail::get_widest_variant(index, operand_count);
 				}
-				
-				return largest_variant;
+
+				unknown = true;
+				continue;
 			}
 
 			if(operands[operand_count].type == OP_NONE) {
 				break;
 			}
 		}
+
+		if(unknown) {
+			return &INSTRUCTION_DB[index];
+		}
 	
-		while(utility::compare_strings(first.name, INSTRUCTION_DB[index].name) == 0) {
+		// only look at variants of the same mnemonic
+		while(index < static_cast<u32>(info.first + info.count)) {
 			const instruction& other = INSTRUCTION_DB[index++];
 	
 			if(operand_count != other.operand_count) {
@@ -206,84 +219,295 @@ namespace baremetal::assembler {
 		return nullptr;
 	}
 
-	auto backend::get_variants(u32 index, const operand* operands) -> utility::dynamic_array<operand_type> {
-		utility::dynamic_array<operand_type> variants;
-		u8 unknown_index = utility::limits<u8>::max();
-	
-		for(u8 i = 0; i < 4; ++i) {
-			if(operands[i].unknown) {
-				unknown_index = i;
+	auto backend::emit_instruction(const instruction* inst, const operand* operands, u8* output) -> u8 {
+		return encoder(inst, operands).emit(output);
+	}
+
+	auto backend::emit_instruction(u32 index, const operand* operands, u8* output) -> u8 {
+		const instruction* inst = get_instruction_direct(index, operands);
+		ASSERT(inst, "no instruction variant available for the provided operands\n");
+
+		return emit_instruction(inst, operands, output);
+	}
+
+	auto backend::compute_size(const instruction* inst, const operand* operands) -> u8 {
+		return encoder(inst, operands).compute_size();
+	}
+
+	auto backend::compute_size(u32 index, const operand* operands) -> u8 {
+		const instruction* inst = get_instruction_direct(index, operands);
+		ASSERT(inst, "no instruction variant available for the provided operands\n");
+
+		return compute_size(inst, operands);
+	}
+
+	encoder::encoder(const instruction* inst, const operand* operands) : m_inst(inst), m_operands(operands) {
+		// locate the memory operand, there's at most one and it's never the last operand
+		for(u8 i = 0; i < 3; ++i) {
+			if(is_operand_mem(m_operands[i].type)) {
+				m_memory_index = i;
 				break;
 			}
 		}
+	}
+
+	auto encoder::emit(u8* output) -> u8 {
+		using specialization = auto (encoder::*)() -> u8;
+
+		// indexed by instruction::enc, has to match the order of the encoding enum
+		static constexpr specialization specializations[] = {
+			&encoder::emit_specialized<ENC_R>,
+			&encoder::emit_specialized<ENC_M>,
+			&encoder::emit_specialized<ENC_MR>,
+			&encoder::emit_specialized<ENC_RM>,
+			&encoder::emit_specialized<ENC_RMR>,
+			&encoder::emit_specialized<ENC_NORMAL>,
+			&encoder::emit_specialized<ENC_NORMALD>,
+			&encoder::emit_specialized<ENC_VEX>,
+			&encoder::emit_specialized<ENC_VEX_R>,
+			&encoder::emit_specialized<ENC_VEX_VM>,
+			&encoder::emit_specialized<ENC_VEX_RM>,
+			&encoder::emit_specialized<ENC_VEX_MR>,
+			&encoder::emit_specialized<ENC_VEX_RVM>,
+			&encoder::emit_specialized<ENC_VEX_RMV>,
+			&encoder::emit_specialized<ENC_VEX_MVR>,
+			&encoder::emit_specialized<ENC_VEX_MVRR>,
+			&encoder::emit_specialized<ENC_VEX_RVMN>,
+			&encoder::emit_specialized<ENC_VEX_RVMS>,
+			&encoder::emit_specialized<ENC_EVEX_RVM>,
+			&encoder::emit_specialized<ENC_EVEX_MVR>,
+			&encoder::emit_specialized<ENC_EVEX_RM>,
+			&encoder::emit_specialized<ENC_EVEX_MR>,
+			&encoder::emit_specialized<ENC_EVEX_VM>,
+			&encoder::emit_specialized<ENC_EVEX_RMZ>,
+			&encoder::emit_specialized<ENC_EVEX_M>,
+			&encoder::emit_specialized<ENC_XOP_VM>,
+			&encoder::emit_specialized<ENC_XOP>,
+		};
+
+		static_assert(sizeof(specializations) / sizeof(specialization) == ENC_XOP + 1, "encoder specialization missing");
+
+		m_data = output;
+		m_data_size = 0;
+
+		return (this->*specializations[m_inst->enc])();
+	}
 
-		u32 current_index = index;
+	auto encoder::compute_size() const -> u8 {
+		using specialization = auto (encoder::*)() const -> u8;
+
+		// indexed by instruction::enc, has to match the order of the encoding enum
+		static constexpr specialization specializations[] = {
+			&encoder::compute_size_specialized<ENC_R>,
+			&encoder::compute_size_specialized<ENC_M>,
+			&encoder::compute_size_specialized<ENC_MR>,
+			&encoder::compute_size_specialized<ENC_RM>,
+			&encoder::compute_size_specialized<ENC_RMR>,
+			&encoder::compute_size_specialized<ENC_NORMAL>,
+			&encoder::compute_size_specialized<ENC_NORMALD>,
+			&encoder::compute_size_specialized<ENC_VEX>,
+			&encoder::compute_size_specialized<ENC_VEX_R>,
+			&encoder::compute_size_specialized<ENC_VEX_VM>,
+			&encoder::compute_size_specialized<ENC_VEX_RM>,
+			&encoder::compute_size_specialized<ENC_VEX_MR>,
+			&encoder::compute_size_specialized<ENC_VEX_RVM>,
+			&encoder::compute_size_specialized<ENC_VEX_RMV>,
+			&encoder::compute_size_specialized<ENC_VEX_MVR>,
+			&encoder::compute_size_specialized<ENC_VEX_MVRR>,
+			&encoder::compute_size_specialized<ENC_VEX_RVMN>,
+			&encoder::compute_size_specialized<ENC_VEX_RVMS>,
+			&encoder::compute_size_specialized<ENC_EVEX_RVM>,
+			&encoder::compute_size_specialized<ENC_EVEX_MVR>,
+			&encoder::compute_size_specialized<ENC_EVEX_RM>,
+			&encoder::compute_size_specialized<ENC_EVEX_MR>,
+			&encoder::compute_size_specialized<ENC_EVEX_VM>,
+			&encoder::compute_size_specialized<ENC_EVEX_RMZ>,
+			&encoder::compute_size_specialized<ENC_EVEX_M>,
+			&encoder::compute_size_specialized<ENC_XOP_VM>,
+			&encoder::compute_size_specialized<ENC_XOP>,
+		};
+
+		static_assert(sizeof(specializations) / sizeof(specialization) == ENC_XOP + 1, "encoder specialization missing");
+
+		return (this->*specializations[m_inst->enc])();
+	}
+
+	template<encoding enc>
+	auto encoder::emit_specialized() -> u8 {
+		// emit individual instruction parts
+		emit_instruction_prefix<enc>();
+		emit_instruction_opcode<enc>();
+		emit_instruction_mod_rm<enc>();
+		emit_instruction_sib();
+		emit_instruction_operands();
+
+		return m_data_size;
+	}
+
+	template<encoding enc>
+	auto encoder::compute_size_specialized() const -> u8 {
+		return static_cast<u8>(
+			get_instruction_prefix_size<enc>() +
+			get_instruction_opcode_size<enc>() +
+			get_instruction_mod_rm_size() +
+			get_instruction_sib_size() +
+			get_instruction_operands_size()
+		);
+	}
 
-		while(is_legal_variant(index, current_index, unknown_index)) {
-			variants.push_back(INSTRUCTION_DB[current_index++].operands[unknown_index]);
+	template<encoding enc>
+	auto encoder::get_instruction_prefix_size() const -> u8 {
+		u8 size = enc == ENC_NORMALD; // first instruction of a double instruction
+
+		if constexpr(is_vex_xop_encoding(enc) || is_evex_encoding(enc)) {
+			return size;
+		}
+
+		// group 4
+		if(m_inst->prefix & ADDRESS_SIZE_OVERRIDE) {
+			size++;
+		}
+		else if(m_inst->has_mem_operand()) {
+			const mem& m = m_operands[m_inst->get_mem_operand()].memory;
+			size += m.base.type == REG_R32 || m.index.type == REG_R32;
 		}
 
-		utility::stable_sort(variants.begin(), variants.end(), [=](auto a, auto b) {
-			const u16 a_width = get_operand_bit_width(a);
-			const u16 b_width = get_operand_bit_width(b);
+		// group 3
+		size += (m_inst->prefix & OPERAND_SIZE_OVERRIDE) != 0;
+
+		// group 2
+		switch(m_inst->prefix & 0b00111100) {
+			case CS_SEGMENT:
+			case SS_SEGMENT:
+			case DS_SEGMENT:
+			case ES_SEGMENT:
+			case FS_SEGMENT:
+			case GS_SEGMENT:
+			case BRANCH_NOT_TAKEN:
+			case BRANCH_TAKEN: size++; break;
+			default:                   break;
+		}
 
-			return a_width < b_width;
-		});
+		// group 1
+		size += (m_inst->prefix & 0b00000011) != 0;
 
-		return variants;
+		return size;
 	}
 
-	auto backend::get_variants_i(u32 index, const operand* operands) -> utility::dynamic_array<inst_variant> {
-		utility::dynamic_array<inst_variant> variants;
-		u8 unknown_index = utility::limits<u8>::max();
-	
-		for(u8 i = 0; i < 4; ++i) {
-			if(operands[i].unknown) {
-				unknown_index = i;
-				break;
+	template<encoding enc>
+	auto encoder::get_instruction_opcode_size() const -> u8 {
+		u8 size = 0;
+
+		// opcode prefix
+		if constexpr(is_rex_encoding(enc)) {
+			if(
+				m_inst->is_rexw() ||
+				is_extended_reg(m_operands[0]) ||
+				is_extended_reg(m_operands[1]) ||
+				is_low_gpr(m_operands[0]) ||
+				is_low_gpr(m_operands[1])
+			) {
+				size++;
+			}
+			else if(m_memory_index < 2) {
+				const mem& memory = m_operands[m_memory_index].memory;
+				size += (memory.has_base && memory.base.index >= 8) || (memory.has_index && memory.index.index >= 8);
 			}
 		}
+		else if constexpr(is_vex_xop_encoding(enc)) {
+			const u8 rex = get_instruction_rex<enc>();
+			const bool x = rex & 0b00000010;
+			const bool b = rex & 0b00000001;
 
-		u32 current_index = index;
+			// two byte or three byte variant
+			size += (!x && !b && !m_inst->is_rexw() && ((m_inst->opcode & 0xffff00) == 0x000f00)) ? 2 : 3;
+		}
+		else if constexpr(is_evex_encoding(enc)) {
+			size += 4;
+		}
 
-		while(is_legal_variant(index, current_index, unknown_index)) {
-			variants.push_back({INSTRUCTION_DB[current_index].operands[unknown_index], current_index});
-			current_index++;
+		u64 opcode = m_inst->opcode;
+
+		if constexpr(is_rex_encoding(enc) == false || enc == ENC_NORMALD) {
+			opcode &= 0xff;
 		}
 
-		utility::stable_sort(variants.begin(), variants.end(), [=](auto a, auto b) {
-			const u16 a_width = get_operand_bit_width(a.type);
-			const u16 b_width = get_operand_bit_width(b.type);
+		if(m_inst->is_ri()) {
+			opcode += get_modrm_rm<enc>() & 0b00000111;
+		}
 
-			return a_width < b_width;
-		});
+		// only non-zero bytes are emitted, except for the last one
+		for(u8 i = 4; i-- > 1;) {
+			size += ((opcode >> (i * 8)) & 0xff) != 0;
+		}
 
-		return variants;
+		return size + 1;
 	}
 
-	auto backend::emit_instruction(const instruction* inst, const operand* operands) -> code {
-		m_data_size = 0;
-		m_operands = operands;
-		m_inst = inst;
+	auto encoder::get_instruction_mod_rm_size() const -> u8 {
+		if(m_memory_index < m_inst->operand_count) {
+			return 1;
+		}
 
-		// emit individual instruction parts
-		emit_instruction_prefix();
-		emit_instruction_opcode();
-		emit_instruction_mod_rm();
-		emit_instruction_sib();
-		emit_instruction_operands();
+		return m_inst->has_broadcast_operand() || m_inst->is_r() || m_inst->is_rm();
+	}
+
+	auto encoder::get_instruction_sib_size() const -> u8 {
+		if(m_memory_index == NO_MEMORY_OPERAND) {
+			return 0;
+		}
+
+		const mem& memory = m_operands[m_memory_index].memory;
 
-		return { .data = m_data, .size = m_data_size };
+		return
+			memory.has_index ||
+			is_stack_pointer(reg(memory.base)) ||
+			m_operands[m_memory_index].type == OP_TMEM ||
+			memory.has_base == false ||
+			memory.has_sse_operands();
 	}
 
-	auto backend::emit_instruction(u32 index, const operand* operands) -> code {
-		const instruction* inst = get_instruction_direct(index, operands);
-		ASSERT(inst, "no instruction variant available for the provided operands\n");
+	auto encoder::get_instruction_operands_size() const -> u8 {
+		u8 size = 0;
 
-		return emit_instruction(inst, operands);
+		for(u8 i = 0; i < m_inst->operand_count; ++i) {
+			const operand_type current = m_inst->operands[i];
+
+			if(is_operand_imm(current) || is_operand_rel(current)) {
+				size += static_cast<u8>(get_operand_bit_width(current) / 8);
+			}
+			else if(is_operand_moff(current)) {
+				size += 8;
+			}
+			else if(is_operand_mem(current)) {
+				// memory displacement
+				const mem& memory = m_operands[i].memory;
+
+				if(!memory.has_displacement()) {
+					if(memory.has_base && memory.base.type != REG_RIP && !is_sse_reg(memory.base)) {
+						continue; // 0 displacements are skipped
+					}
+				}
+
+				if(
+					memory.has_base &&
+					memory.base.type != REG_RIP &&
+					!is_sse_reg(memory.base) &&
+					memory.displacement.min_bits <= 8
+				) {
+					size += 1;
+				}
+				else {
+					size += 4;
+				}
+			}
+		}
+
+		// trailing register encoded as an immediate
+		return size + m_inst->is_is4();
 	}
 
-	void backend::emit_instruction_operands() {
+	void encoder::emit_instruction_operands() {
 		for(u8 i = 0; i < m_inst->operand_count; ++i) {
 			const operand_type current = m_inst->operands[i];
 
@@ -300,7 +524,7 @@ namespace baremetal::assembler {
 				const mem memory = m_operands[i].memory;
 				imm displacement = memory.displacement;
 
-				if(displacement.value == 0) {
+				if(!memory.has_displacement()) {
 					if(memory.has_base && memory.base.type != REG_RIP && !is_sse_reg(memory.base)) {
 						continue; // skip 0 displacements
 					}
@@ -349,13 +573,14 @@ namespace baremetal::assembler {
 		}
 	}
 
-	void backend::emit_instruction_prefix() {
-		if(m_inst->enc == ENC_NORMALD) {
+	template<encoding enc>
+	void encoder::emit_instruction_prefix() {
+		if constexpr(enc == ENC_NORMALD) {
 			// instruction composed of two instructions, emit the first one here (encoded as a part of the opcode)
 			push_byte((m_inst->opcode & 0x0000FF00) >> 8);
 		}
 
-		if(m_inst->is_vex_xop() || m_inst->is_evex()) {
+		if constexpr(is_vex_xop_encoding(enc) || is_evex_encoding(enc)) {
 			return;
 		}
 
@@ -400,24 +625,25 @@ namespace baremetal::assembler {
 		}
 	}
 
-	void backend::emit_instruction_opcode() {
+	template<encoding enc>
+	void encoder::emit_instruction_opcode() {
 		// opcode prefix
-		if(m_inst->is_rex()) {
-			emit_opcode_prefix_rex();
+		if constexpr(is_rex_encoding(enc)) {
+			emit_opcode_prefix_rex<enc>();
 		}
-		else if(m_inst->is_vex_xop()) {
-			emit_opcode_prefix_vex();
+		else if constexpr(is_vex_xop_encoding(enc)) {
+			emit_opcode_prefix_vex<enc>();
 		}
-		else if(m_inst->is_evex()) {
-			emit_opcode_prefix_evex();
+		else if constexpr(is_evex_encoding(enc)) {
+			emit_opcode_prefix_evex<enc>();
 		}
 		else {
-			ASSERT(false, "unknown instruction encoding '{}' specified (opcode prefix)\n", static_cast<u8>(m_inst->enc));
+			ASSERT(false, "unknown instruction encoding '{}' specified (opcode prefix)\n", static_cast<u8>(enc));
 		}
 
 		u64 opcode = m_inst->opcode;
 
-		if(m_inst->is_rex() == false || m_inst->enc == ENC_NORMALD) {
+		if constexpr(is_rex_encoding(enc) == false || enc == ENC_NORMALD) {
 			// VEX instructions have the leading opcode encoded in themselves, so we have to skip it here
 			// skip the first byte, since we've already pushed it (double instruction)
 			opcode &= 0xff;
@@ -425,7 +651,7 @@ namespace baremetal::assembler {
 
 		// opcode extensions (add a specific register to the opcode itself)
 		if(m_inst->is_ri()) {
-			opcode += get_modrm_rm() & 0b00000111;
+			opcode += get_modrm_rm<enc>() & 0b00000111;
 		}
 
 		// append opcode bytes
@@ -442,9 +668,10 @@ namespace baremetal::assembler {
 		push_byte(opcode & 0xff);
 	}
 
-	void backend::emit_instruction_mod_rm() {
-		u8 reg = get_modrm_reg();
-		u8 rm = get_modrm_rm();
+	template<encoding enc>
+	void encoder::emit_instruction_mod_rm() {
+		u8 reg = get_modrm_reg<enc>();
+		u8 rm = get_modrm_rm<enc>();
 
 		if(m_inst->is_rm() && !m_inst->is_is4()) {
 			// rm-as-reg
@@ -452,13 +679,9 @@ namespace baremetal::assembler {
 		}
 
 		// memory operands
-		for(u8 i = 0; i < m_inst->operand_count; ++i) {
-			if(!is_operand_mem(m_operands[i].type)) {
-				continue;
-			}
-
+		if(m_memory_index < m_inst->operand_count) {
 			const bool sib = has_sib();
-			const auto memory = m_operands[i].memory;
+			const mem& memory = m_operands[m_memory_index].memory;
 
 			ASSERT(memory.displacement.min_bits <= 32, "too many displacement bits");
 
@@ -471,7 +694,7 @@ namespace baremetal::assembler {
 			else if(is_sse_reg(memory.base)) {
 				push_byte(detail::indirect(reg, 0b100));
 			}
-			else if(memory.displacement.value == 0) {
+			else if(!memory.has_displacement()) {
 				push_byte(detail::indirect(reg, sib ? 0b100 : memory.base.index));
 			}
 			else if(memory.displacement.min_bits <= 8) {
@@ -495,23 +718,14 @@ namespace baremetal::assembler {
 		}
 	}
 
-	void backend::emit_instruction_sib() {
-		operand operand;
-
-		// locate the memory operand
-		for(u8 i = 0; i < 3; ++i) {
-			if(is_operand_mem(m_operands[i].type)) {
-				operand = m_operands[i];
-				break;
-			}
-		}
-
+	void encoder::emit_instruction_sib() {
 		// no memory operand
-		if(operand.type == OP_NONE) {
+		if(m_memory_index == NO_MEMORY_OPERAND) {
 			return;
 		}
 
-		const mem memory = operand.memory;
+		const operand& operand = m_operands[m_memory_index];
+		const mem& memory = operand.memory;
 		const u8 scale   = memory.has_base  ? memory.s           : 0b000;
 		const u8 index   = memory.has_index ? memory.index.index : 0b100;
 		const u8 base    = memory.has_base  ? memory.base.index  : 0b101;
@@ -533,9 +747,10 @@ namespace baremetal::assembler {
 		}
 	}
 
-	void backend::emit_opcode_prefix_evex() {
-		const u8 rex = get_instruction_rex();
-		const u8 modrm = get_modrm_reg();
+	template<encoding enc>
+	void encoder::emit_opcode_prefix_evex() {
+		const u8 rex = get_instruction_rex<enc>();
+		const u8 modrm = get_modrm_reg<enc>();
 		u8 prefix[3] = {};
 
 		push_byte(0x62); // EVEX prefix
@@ -547,14 +762,14 @@ namespace baremetal::assembler {
 		prefix[0] |= m_inst->get_opcode_map();                  // map select [____0XXX]
 
 		prefix[1] |= static_cast<u8>((m_inst->is_rexw()) << 7); // W          [X_______]
-		prefix[1] |= get_instruction_vvvv() << 3;               // ~VVVV      [_XXXX___]
+		prefix[1] |= get_instruction_vvvv<enc>() << 3;          // ~VVVV      [_XXXX___]
 		prefix[1] |= 0b1 << 2;                                  //            [_____1__]
 		prefix[1] |= m_inst->get_additional_prefix();           // IMP        [______XX]
 
 		prefix[2] |= m_inst->get_evex_zero() << 7;              // zero mask  [X_______]
 		prefix[2] |= m_inst->get_evex_operand_type();           // size       [_XX_____]
 		prefix[2] |= m_inst->has_broadcast_operand() << 4;      // broadcast  [___X____]
-		prefix[2] |= !get_instruction_v() << 3;                 // ~V         [____X___]
+		prefix[2] |= !get_instruction_v<enc>() << 3;            // ~V         [____X___]
 		prefix[2] |= get_mask_reg();                            // mask       [_____XXX]
 
 		push_byte(prefix[0]);
@@ -562,8 +777,9 @@ namespace baremetal::assembler {
 		push_byte(prefix[2]);
 	}
 
-	void backend::emit_opcode_prefix_vex() {
-		const u8 rex = get_instruction_rex();
+	template<encoding enc>
+	void encoder::emit_opcode_prefix_vex() {
+		const u8 rex = get_instruction_rex<enc>();
 
 		const bool x = rex & 0b00000010;
 		const bool b = rex & 0b00000001;
@@ -571,14 +787,15 @@ namespace baremetal::assembler {
 		// a VEX instruction whose values for certain fields are VEX.~X == 1, VEX.~B == 1, VEX.W/E == 0
 		// and map_select == b00001 may be encoded using the two byte VEX escape prefix (XOP)
 		if(!x && !b && !m_inst->is_rexw() && ((m_inst->opcode & 0xffff00) == 0x000f00)) {
-			emit_opcode_prefix_vex_two(); // two byte variant
+			emit_opcode_prefix_vex_two<enc>(); // two byte variant
 		}
 		else {
-			emit_opcode_prefix_vex_three(); // three byte variant
+			emit_opcode_prefix_vex_three<enc>(); // three byte variant
 		}
 	}
 
-	void backend::emit_opcode_prefix_rex() {
+	template<encoding enc>
+	void encoder::emit_opcode_prefix_rex() {
 		if(
 			m_inst->is_rexw() || 
 			is_extended_reg(m_operands[0]) ||
@@ -586,42 +803,41 @@ namespace baremetal::assembler {
 			is_low_gpr(m_operands[0]) || 
 			is_low_gpr(m_operands[1])
 		) {
-			push_byte(get_instruction_rex());
+			push_byte(get_instruction_rex<enc>());
 		}
-		else if(is_operand_mem(m_operands[0].type)) {
-			emit_opcode_prefix_rex_mem(m_operands[0].memory);
-		}
-		else if(is_operand_mem(m_operands[1].type)) {
-			emit_opcode_prefix_rex_mem(m_operands[1].memory);
+		else if(m_memory_index < 2) {
+			emit_opcode_prefix_rex_mem(m_operands[m_memory_index].memory);
 		}
 	}
 
-	void backend:: emit_opcode_prefix_rex_mem(const mem& memory) {
+	void encoder::emit_opcode_prefix_rex_mem(const mem& memory) {
 		// if our memory operand contains an extended register we have to emit a rex prefix for it
 		if((memory.has_base && memory.base.index >= 8) || (memory.has_index && memory.index.index >= 8)) {
 			push_byte(detail::rex(false, 0, memory.base.index, memory.index.index));
 		}
 	}
 
-	void backend::emit_opcode_prefix_vex_two() {
-		const u8 rex = get_instruction_rex();
+	template<encoding enc>
+	void encoder::emit_opcode_prefix_vex_two() {
+		const u8 rex = get_instruction_rex<enc>();
 		u8 prefix = 0;
 
 		push_byte(0xc5); // two byte VEX prefix
 
 		prefix |= !(rex & 0b00000100) << 7;         // ~R    [X_______]
-		prefix |= get_instruction_vvvv() << 3;      // ~vvvv [_XXXX___]
+		prefix |= get_instruction_vvvv<enc>() << 3; // ~vvvv [_XXXX___]
 		prefix |= m_inst->get_vector_length() << 2; // L     [_____X__]
 		prefix |= m_inst->get_additional_prefix();  // IMP   [______XX]
 
 		push_byte(prefix);
 	}
 
-	void backend::emit_opcode_prefix_vex_three() {
-		const u8 rex = get_instruction_rex();
+	template<encoding enc>
+	void encoder::emit_opcode_prefix_vex_three() {
+		const u8 rex = get_instruction_rex<enc>();
 		u8 prefix[2] = {};
 
-		if(m_inst->is_xop()) {
+		if constexpr(is_xop_encoding(enc)) {
 			push_byte(0x8f); // XOP prefix
 		} else {
 			push_byte(0xc4); // VEX prefix
@@ -633,7 +849,7 @@ namespace baremetal::assembler {
 		prefix[0] |= m_inst->get_opcode_map();                  // map_select [___XXXXX]
 
 		prefix[1] |= static_cast<u8>((m_inst->is_rexw()) << 7); // W/E        [X_______]
-		prefix[1] |= get_instruction_vvvv() << 3;               // ~vvvv      [_XXXX___]
+		prefix[1] |= get_instruction_vvvv<enc>() << 3;          // ~vvvv      [_XXXX___]
 		prefix[1] |= m_inst->get_vector_length() << 2;          // L          [_____X__]
 		prefix[1] |= m_inst->get_additional_prefix();           // pp         [______XX]
 		
@@ -641,29 +857,32 @@ namespace baremetal::assembler {
 		push_byte(prefix[1]);
 	}
 
-	void backend::emit_data_operand(u64 data, u16 bit_width) {
+	void encoder::emit_data_operand(u64 data, u16 bit_width) {
 		for(u16 i = 0; i < bit_width / 8; ++i) {
 			push_byte(data >> (i * 8) & 0xFF);
 		}
 	}
 
-	auto backend::get_instruction_rex() -> u8 {
+	template<encoding enc>
+	auto encoder::get_instruction_rex() const -> u8 {
 		const bool is_rexw = m_inst->is_rexw();
 
-		const u8 index = get_sib_index();
-		const u8 reg = get_modrm_reg();
-		const u8 rm = get_modrm_rm();
+		const u8 index = get_sib_index<enc>();
+		const u8 reg = get_modrm_reg<enc>();
+		const u8 rm = get_modrm_rm<enc>();
 
 		// calculate the REX prefix
 		return detail::rex(is_rexw, reg, rm, index);
 	}
 
-	auto backend::get_instruction_vvvv() -> u8 {
-		return static_cast<u8>((~get_extending_reg() & 0b00001111));
+	template<encoding enc>
+	auto encoder::get_instruction_vvvv() const -> u8 {
+		return static_cast<u8>((~get_extending_reg<enc>() & 0b00001111));
 	}
 
-	auto backend::get_instruction_v() -> u8 {
-		u8 rx = get_extending_reg();
+	template<encoding enc>
+	auto encoder::get_instruction_v() const -> u8 {
+		u8 rx = get_extending_reg<enc>();
 
 		if(
 			is_operand_mem(m_inst->operands[1]) &&
@@ -676,7 +895,8 @@ namespace baremetal::assembler {
 		return rx & 0b00010000;
 	}
 	
-	auto backend::get_extending_reg() -> u8 {
+	template<encoding enc>
+	auto encoder::get_extending_reg() const -> u8 {
 		u8 ext = 0;
 
 		const u8 registers[4] = {
@@ -686,7 +906,7 @@ namespace baremetal::assembler {
 			detail::extract_operand_reg(m_operands[3]),
 		};
 
-		switch(m_inst->enc) {
+		switch(enc) {
 			case ENC_VEX_VM:   return registers[0];
 			case ENC_EVEX_RMZ: return registers[0];
 			case ENC_XOP_VM:   return registers[0];
@@ -702,7 +922,7 @@ namespace baremetal::assembler {
 			default: break;
 		}
 
-		switch(m_inst->enc) {
+		switch(enc) {
 			case ENC_EVEX_RVM: {
 				if(m_inst->operand_count == 2) {
 					ext = 0;
@@ -732,7 +952,8 @@ namespace baremetal::assembler {
 		return ext;
 	}
 
-	auto backend::get_modrm_reg() -> u8 {
+	template<encoding enc>
+	auto encoder::get_modrm_reg() const -> u8 {
 		const u8 registers[4] = {
 			detail::extract_operand_reg(m_operands[0]),
 			detail::extract_operand_reg(m_operands[1]),
@@ -742,7 +963,7 @@ namespace baremetal::assembler {
 
 		u8 reg = 0;
 
-		switch(m_inst->enc) {
+		switch(enc) {
 			case ENC_VEX_RVMS: reg = registers[0]; break;
 			case ENC_VEX_RVMN: reg = registers[0]; break;
 			case ENC_RM:       reg = registers[0]; break;
@@ -765,7 +986,7 @@ namespace baremetal::assembler {
 			default: break;
 		}
 
-		switch(m_inst->enc) {
+		switch(enc) {
 			case ENC_EVEX_RVM: {
 				if(m_inst->operand_count == 2) {
 					if(
@@ -803,7 +1024,8 @@ namespace baremetal::assembler {
 		return reg;
 	}
 
-	auto backend::get_modrm_rm() -> u8 {
+	template<encoding enc>
+	auto encoder::get_modrm_rm() const -> u8 {
 		const u8 registers[4] = {
 			detail::extract_operand_reg(m_operands[0]),
 			detail::extract_operand_reg(m_operands[1]),
@@ -813,7 +1035,7 @@ namespace baremetal::assembler {
 
 		u8 rm = 0;
 
-		switch(m_inst->enc) {
+		switch(enc) {
 			case ENC_VEX_MR:   rm = registers[0]; break;
 			case ENC_XOP:      rm = registers[0]; break;
 			case ENC_EVEX_MVR: rm = registers[0]; break; 
@@ -842,7 +1064,7 @@ namespace baremetal::assembler {
 			default: break;
 		}
 
-		switch(m_inst->enc) {
+		switch(enc) {
 			case ENC_NORMAL: {
 				if(m_inst->operands[0] == OP_EAX || m_inst->operands[0] == OP_RAX || m_inst->operands[0] == OP_AX) {
 					rm = registers[1];
@@ -908,7 +1130,8 @@ namespace baremetal::assembler {
 
 	}
 
-	auto backend::get_sib_index() -> u8 {
+	template<encoding enc>
+	auto encoder::get_sib_index() const -> u8 {
 		u8 index = 0;
 
 		const u8 registers[4] = {
@@ -918,7 +1141,7 @@ namespace baremetal::assembler {
 			detail::extract_operand_reg(m_operands[3]),
 		};
 
-		switch(m_inst->enc) {
+		switch(enc) {
 			case ENC_EVEX_VM:  if(registers[1] > 15) { return registers[1]; } break;
 			case ENC_VEX_RM:   if(registers[1] > 15) { return registers[1]; } break;
 			case ENC_VEX_VM:   if(registers[1] > 15) { return registers[1]; } break;
@@ -940,7 +1163,7 @@ namespace baremetal::assembler {
 			}
 		}
 
-		switch(m_inst->enc) {
+		switch(enc) {
 			case ENC_EVEX_RVM: {
 				if(m_inst->operand_count == 2) {
 					if(
@@ -1009,7 +1232,7 @@ namespace baremetal::assembler {
 		return index;
 	}
 
-	auto backend::get_mask_reg() -> u8 {
+	auto encoder::get_mask_reg() const -> u8 {
 		if(m_inst->has_masked_operand() == false) {
 			return 0;
 		}
@@ -1022,25 +1245,16 @@ namespace baremetal::assembler {
 		return m_operands[0].mr.k; // masked register
 	}
 
-	auto backend::has_sib() -> bool {
-		operand operand;
-
-		for(u8 i = 0; i < 3; ++i) {
-			if(is_operand_mem(m_operands[i].type)) {
-				operand = m_operands[i];
-				break;
-			}
-		}
-
-		if(operand.type == OP_NONE) {
+	auto encoder::has_sib() const -> bool {
+		if(m_memory_index == NO_MEMORY_OPERAND) {
 			return false;
 		}
 
-		if(operand.type == OP_TMEM) {
+		if(m_operands[m_memory_index].type == OP_TMEM) {
 			return true;
 		}
 
-		mem memory = operand.memory;
+		const mem& memory = m_operands[m_memory_index].memory;
 	
 		if(memory.has_index) {
 			return true;
@@ -1057,7 +1271,7 @@ namespace baremetal::assembler {
 		return false;
 	}
 
-	void backend::push_byte(u8 value) {
+	void encoder::push_byte(u8 value) {
 		m_data[m_data_size++] = value;
 	}
 
@@ -1067,4 +1281,33 @@ namespace baremetal::assembler {
 
 		return index >= ja_index && index <= jz_index;
 	}
+
+	// the size specializations are also used outside of this translation unit (see builder::emit)
+	template auto encoder::compute_size_specialized<ENC_R>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_M>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_MR>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_RM>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_RMR>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_NORMAL>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_NORMALD>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_VEX>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_VEX_R>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_VEX_VM>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_VEX_RM>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_VEX_MR>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_VEX_RVM>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_VEX_RMV>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_VEX_MVR>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_VEX_MVRR>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_VEX_RVMN>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_VEX_RVMS>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_EVEX_RVM>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_EVEX_MVR>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_EVEX_RM>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_EVEX_MR>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_EVEX_VM>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_EVEX_RMZ>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_EVEX_M>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_XOP_VM>() const -> u8;
+	template auto encoder::compute_size_specialized<ENC_XOP>() const -> u8;
 } // namespace baremetal::assembler
@@ -1,5 +1,5 @@
 #pragma once
-#include "assembler/instruction/instruction.h"
+#include "assembler/instruction/instruction_index.h"
 
 #include <utility/containers/dynamic_array.h>
 
@@ -31,69 +31,126 @@ namespace baremetal::assembler {
 		 */
 		[[nodiscard]] auto sign_extend_representable(u64 value, u8 src) -> bool;
 		[[nodiscard]] auto sign_extend(u64 x, u8 x_bits) -> u64;
+
+		// first of the widest variants of the specified operand, 'index' if the operand has no variants
+		[[nodiscard]] auto get_widest_variant(u32 index, u8 operand_index) -> u32;
+
+		// offset of the immediate operand from the start of the encoded instruction, which is 'size'
+		// bytes long
+		[[nodiscard]] auto get_immediate_offset(const instruction* inst, u8 operand_index, u8 size) -> u8;
 	} // namespace detail
 
 	using namespace utility::types;
 
-	struct inst_variant {
-		operand_type type;
-		u32 index;
-	};
-
 	struct backend {
-		struct code {
-			u8* data;
-			u8 size;
-		};
-
 		[[nodiscard]] static auto get_instruction_by_name(const char* name) -> u32;
-		[[nodiscard]] static auto get_variants(u32 index, const operand* operands) -> utility::dynamic_array<operand_type>;
-		[[nodiscard]] static auto get_variants_i(u32 index, const operand* operands) -> utility::dynamic_array<inst_variant>;
 
-		[[nodiscard]] static auto emit_instruction(const instruction* inst, const operand* operands) -> code;
-		[[nodiscard]] static auto emit_instruction(u32 index, const operand* operands) -> code;
+		// encodes the instruction into 'output', which has to be large enough to hold it
+		// (MAX_INSTRUCTION_SIZE bytes always are), returns the size of the encoded instruction
+		static auto emit_instruction(const instruction* inst, const operand* operands, u8* output) -> u8;
+		static auto emit_instruction(u32 index, const operand* operands, u8* output) -> u8;
+
+		// size of the encoded instruction, equal to the value returned by emit_instruction, but
+		// doesn't encode anything, used wherever we only care about instruction sizes (parsing,
+		// relaxation)
+		[[nodiscard]] static auto compute_size(const instruction* inst, const operand* operands) -> u8;
+		[[nodiscard]] static auto compute_size(u32 index, const operand* operands) -> u8;
 	private:
 		// instruction selection
 		[[nodiscard]] static auto get_instruction_direct(u32 index, const operand* operands) -> const instruction*;
+	};
+
+	// encoder of a single instruction, holds no global state and writes into a caller-owned buffer,
+	// hence multiple encoders can be used at the same time (ie. when parsing chunks in parallel).
+	// every encoding has its own specialization of the encoder, in which everything that only
+	// depends on the encoding (prefix kind, modR/M operand roles, ...) is resolved at compile time,
+	// the specializations are selected through a table indexed by instruction::enc
+	class encoder {
+	public:
+		encoder(const instruction* inst, const operand* operands);
+
+		// writes the encoded instruction into 'output', returns the number of bytes written
+		auto emit(u8* output) -> u8;
+		[[nodiscard]] auto compute_size() const -> u8;
+
+		// the specialization of compute_size for the encoding of the instruction, skips the table
+		// when the encoding is known at compile time (see builder::emit)
+		template<encoding enc>
+		[[nodiscard]] auto compute_size_specialized() const -> u8;
+	private:
+		template<encoding enc>
+		auto emit_specialized() -> u8;
 
 		// instruction parts
-		static void emit_instruction_prefix();
-		static void emit_instruction_opcode();
-		static void emit_instruction_mod_rm();
-		static void emit_instruction_sib();
-		static void emit_instruction_operands();
+		template<encoding enc>
+		void emit_instruction_prefix();
+		template<encoding enc>
+		void emit_instruction_opcode();
+		template<encoding enc>
+		void emit_instruction_mod_rm();
+
+		void emit_instruction_sib();
+		void emit_instruction_operands();
+
+		// instruction part sizes, mirror the functions above
+		template<encoding enc>
+		[[nodiscard]] auto get_instruction_prefix_size() const -> u8;
+		template<encoding enc>
+		[[nodiscard]] auto get_instruction_opcode_size() const -> u8;
+
+		[[nodiscard]] auto get_instruction_mod_rm_size() const -> u8;
+		[[nodiscard]] auto get_instruction_sib_size() const -> u8;
+		[[nodiscard]] auto get_instruction_operands_size() const -> u8;
 
 		// instruction prefixes
-		static void emit_opcode_prefix_evex();
-		static void emit_opcode_prefix_vex();
-		static void emit_opcode_prefix_rex();
+		template<encoding enc>
+		void emit_opcode_prefix_evex();
+		template<encoding enc>
+		void emit_opcode_prefix_vex();
+		template<encoding enc>
+		void emit_opcode_prefix_rex();
 
 		// misc
-		static void emit_opcode_prefix_vex_two();
-		static void emit_opcode_prefix_vex_three();
+		template<encoding enc>
+		void emit_opcode_prefix_vex_two();
+		template<encoding enc>
+		void emit_opcode_prefix_vex_three();
 
-		static void emit_opcode_prefix_rex_mem(const mem& memory);
-		static void emit_data_operand(u64 data, u16 bit_width);
+		void emit_opcode_prefix_rex_mem(const mem& memory);
+		void emit_data_operand(u64 data, u16 bit_width);
 		
-		[[nodiscard]] static auto get_instruction_vvvv() -> u8;
-		[[nodiscard]] static auto get_instruction_rex() -> u8;
-		[[nodiscard]] static auto get_instruction_v() -> u8;
+		template<encoding enc>
+		[[nodiscard]] auto get_instruction_vvvv() const -> u8;
+		template<encoding enc>
+		[[nodiscard]] auto get_instruction_rex() const -> u8;
+		template<encoding enc>
+		[[nodiscard]] auto get_instruction_v() const -> u8;
 
 		// registers
-		[[nodiscard]] static auto get_extending_reg() -> u8;
-		[[nodiscard]] static auto get_sib_index() -> u8;
-		[[nodiscard]] static auto get_modrm_reg() -> u8;
-		[[nodiscard]] static auto get_modrm_rm() -> u8;
-		[[nodiscard]] static auto get_mask_reg() -> u8;
-
-		[[nodiscard]] static auto has_sib() -> bool;
-		static void push_byte(u8 value);
+		template<encoding enc>
+		[[nodiscard]] auto get_extending_reg() const -> u8;
+		template<encoding enc>
+		[[nodiscard]] auto get_sib_index() const -> u8;
+		template<encoding enc>
+		[[nodiscard]] auto get_modrm_reg() const -> u8;
+		template<encoding enc>
+		[[nodiscard]] auto get_modrm_rm() const -> u8;
+
+		[[nodiscard]] auto get_mask_reg() const -> u8;
+
+		[[nodiscard]] auto has_sib() const -> bool;
+		void push_byte(u8 value);
 	private:
-		static const instruction* m_inst;
-		static const operand* m_operands;
+		static constexpr u8 NO_MEMORY_OPERAND = utility::limits<u8>::max();
+
+		const instruction* m_inst;
+		const operand* m_operands;
+
+		// index of the first memory operand (within the first 3 operands), or NO_MEMORY_OPERAND
+		u8 m_memory_index = NO_MEMORY_OPERAND;
 
-		static u8 m_data_size;
-		static u8 m_data[MAX_INSTRUCTION_SIZE];
+		u8* m_data = nullptr;
+		u8 m_data_size = 0;
 	};
 
 	[[nodiscard]] auto is_jump_or_branch_inst(u32 index) -> bool;
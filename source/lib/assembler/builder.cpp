@@ -0,0 +1,279 @@
+#include "builder.h"
+
+#include "assembler/frontend.h"
+
+namespace baremetal::assembler {
+	namespace detail {
+		[[nodiscard]] auto get_memory_operand(const mem& memory, operand_type type) -> operand {
+			operand op;
+
+			op.type = type;
+			op.memory = memory;
+
+			// vector registers turn the location into a vector memory operand, same as in the frontend
+			if(memory.has_base) {
+				switch(memory.base.type) {
+					case REG_XMM: op.type = OP_VM32X; break;
+					case REG_YMM: op.type = OP_VM32Y; break;
+					case REG_ZMM: op.type = OP_VM32Z; break;
+					default: break;
+				}
+			}
+
+			if(memory.has_index) {
+				switch(memory.index.type) {
+					case REG_XMM: op.type = OP_VM32X; break;
+					case REG_YMM: op.type = OP_VM32Y; break;
+					case REG_ZMM: op.type = OP_VM32Z; break;
+					default: break;
+				}
+			}
+
+			return op;
+		}
+
+		// mnemonic ID of the variants with the specified name
+		constexpr auto get_static_mnemonic(const char* name) -> u16 {
+			for(u32 i = 0; i < INSTRUCTION_DB_SIZE; ++i) {
+				const char* current = INSTRUCTION_DB[i].name;
+				u64 j = 0;
+
+				while(name[j] != '\0' && current[j] == name[j]) {
+					j++;
+				}
+
+				if(current[j] == name[j]) {
+					return INSTRUCTION_DB[i].mnemonic;
+				}
+			}
+
+			return utility::limits<u16>::max();
+		}
+
+		constexpr auto is_static_variant(u32 index, operand_type first, operand_type second) -> bool {
+			const instruction& inst = INSTRUCTION_DB[index];
+			return inst.operand_count == 2 && inst.operands[0] == first && inst.operands[1] == second;
+		}
+
+		// the runner compares every compile time selection of register and immediate operands with the
+		// runtime one, these pin down the kind of selection each operand category leads to
+		constexpr u16 ADD = get_static_mnemonic("add");
+
+		// registers are known, the first matching variant always matches
+		constexpr static_selection ADD_REG_REG = select_static<reg64, reg64>(ADD);
+
+		static_assert(ADD_REG_REG.kind == SELECTION_STATIC && ADD_REG_REG.count == 1);
+		static_assert(is_static_variant(ADD_REG_REG.indices[0], OP_R64, OP_R64));
+		static_assert(ADD_REG_REG.direct == ADD_REG_REG.indices[0]);
+
+		// 'rax' specific variants depend on the register index, and are checked at runtime
+		constexpr static_selection ADD_REG_IMM = select_static<reg64, imm>(ADD);
+
+		static_assert(ADD_REG_IMM.kind == SELECTION_CANDIDATES && ADD_REG_IMM.count == 2);
+		static_assert(is_static_variant(ADD_REG_IMM.indices[0], OP_RAX, OP_I32));
+		static_assert(is_static_variant(ADD_REG_IMM.indices[1], OP_R64, OP_I8));
+
+		// memory operands are only typed at runtime
+		static_assert(select_static<operand, reg64>(ADD).kind == SELECTION_DYNAMIC);
+		static_assert(select_static<reg64, operand>(ADD).kind == SELECTION_DYNAMIC);
+		static_assert(select_static<operand, imm>(ADD).kind == SELECTION_DYNAMIC);
+	} // namespace detail
+
+	auto ptr(reg base, i32 displacement) -> mem {
+		mem memory = {};
+
+		memory.base = base;
+		memory.has_base = true;
+		memory.displacement = imm(displacement);
+
+		return memory;
+	}
+
+	auto ptr(reg base, reg index, scale s, i32 displacement) -> mem {
+		mem memory = ptr(base, displacement);
+
+		memory.index = index;
+		memory.has_index = true;
+		memory.s = s;
+
+		return memory;
+	}
+
+	auto m8(const mem& memory) -> operand {
+		return detail::get_memory_operand(memory, OP_M8);
+	}
+
+	auto m16(const mem& memory) -> operand {
+		return detail::get_memory_operand(memory, OP_M16);
+	}
+
+	auto m32(const mem& memory) -> operand {
+		return detail::get_memory_operand(memory, OP_M32);
+	}
+
+	auto m64(const mem& memory) -> operand {
+		return detail::get_memory_operand(memory, OP_M64);
+	}
+
+	auto m80(const mem& memory) -> operand {
+		return detail::get_memory_operand(memory, OP_M80);
+	}
+
+	auto m128(const mem& memory) -> operand {
+		return detail::get_memory_operand(memory, OP_M128);
+	}
+
+	auto m256(const mem& memory) -> operand {
+		return detail::get_memory_operand(memory, OP_M256);
+	}
+
+	auto m512(const mem& memory) -> operand {
+		return detail::get_memory_operand(memory, OP_M512);
+	}
+
+	builder::builder() : m_module(&m_context) {}
+
+	auto builder::create_label(const utility::string_view& name) -> label {
+		m_labels.push_back({ .name = m_context.strings.add(name), .bound = false });
+		return { .index = static_cast<u32>(m_labels.get_size() - 1) };
+	}
+
+	auto builder::create_label() -> label {
+		// '@' followed by the label index, '@' never appears in identifiers produced by the lexer
+		char digits[20];
+		char name[21];
+		u64 index = m_labels.get_size();
+		u8 digit_count = 0;
+
+		do {
+			digits[digit_count++] = static_cast<char>('0' + index % 10);
+			index /= 10;
+		} while(index != 0);
+
+		name[0] = '@';
+
+		for(u8 i = 0; i < digit_count; ++i) {
+			name[i + 1] = digits[digit_count - i - 1];
+		}
+
+		return create_label(utility::string_view(name, digit_count + 1));
+	}
+
+	auto builder::bind(label target) -> utility::result<void> {
+		label_info& info = m_labels[target.index];
+
+		if(info.bound) {
+			return utility::error("label has already been bound");
+		}
+
+		TRY(m_module.declare_symbol(info.name));
+		m_module.commit_label_block(info.name);
+
+		info.bound = true;
+		return SUCCESS;
+	}
+
+	void builder::global(label target) {
+		m_module.declare_global(m_labels[target.index].name);
+	}
+
+	void builder::set_section(const utility::string_view& name) {
+		m_module.set_section(m_context.strings.add(name));
+	}
+
+	void builder::data(const u8* data, u64 size) {
+		m_module.commit_data_block(data, size);
+	}
+
+	auto builder::finish() -> utility::result<module> {
+		for(const label_info& info : m_labels) {
+			if(!info.bound) {
+				return utility::error("unbound label");
+			}
+		}
+
+		m_module.commit_instruction_block(BB_INSTRUCTION);
+		TRY(m_module.verify_symbols());
+
+		return m_module;
+	}
+
+	auto builder::emit_instruction(u16 mnemonic, const operand* operands, u8 count) -> utility::result<void> {
+		const u32 index = get_selection(mnemonic, operands, count);
+
+		if(index == utility::limits<u32>::max()) {
+			return utility::error("invalid operand combination for the specified instruction");
+		}
+
+		stage_instruction(index, operands, count);
+		return SUCCESS;
+	}
+
+	auto builder::emit_candidates(const u32* indices, u8 candidate_count, const operand* operands, u8 count) -> utility::result<void> {
+		// the candidates have already been narrowed down by their operand types, only the values are
+		// left to check
+		for(u8 i = 0; i < candidate_count; ++i) {
+			if(detail::is_operand_match(get_instruction_selection(indices[i]), operands, 0, count)) {
+				stage_instruction(indices[i], operands, count);
+				return SUCCESS;
+			}
+		}
+
+		return utility::error("invalid operand combination for the specified instruction");
+	}
+
+	auto builder::get_selection(u16 mnemonic, const operand* operands, u8 count) -> u32 {
+		operand staged[4];
+
+		// ensure our destination is clean, same as in the frontend
+		utility::memset(staged, 0, sizeof(operand) * 4);
+		utility::memcpy(staged, operands, sizeof(operand) * count);
+
+		return detail::select_instruction(mnemonic, staged, count, 0);
+	}
+
+	void builder::retype_operands(u32 index, const operand* operands, u8 count, operand* staged) {
+		utility::memset(staged, 0, sizeof(operand) * 4);
+		utility::memcpy(staged, operands, sizeof(operand) * count);
+
+		// retype the operands to the types of the selected variant, ie. immediates can actually be
+		// relocations, symbolic operands are retyped once they're resolved
+		for(u8 i = 0; i < count; ++i) {
+			if(!staged[i].unknown) {
+				staged[i].type = INSTRUCTION_DB[index].operands[i];
+			}
+		}
+	}
+
+	void builder::stage_instruction(u32 index, const operand* operands, u8 count) {
+		operand staged[4];
+
+		retype_operands(index, operands, count, staged);
+		push_instruction(index, staged, backend::compute_size(index, staged));
+	}
+
+	void builder::push_instruction(u32 index, const operand* staged, u8 size) {
+		m_module.stage_instruction(staged, index, size);
+
+		// force a branch block
+		if(is_jump_or_branch_inst(index)) {
+			m_module.commit_instruction_block(BB_BRANCH);
+		}
+	}
+
+	auto builder::get_operand(const operand& op) -> operand {
+		return op;
+	}
+
+	auto builder::get_operand(const reg& r) -> operand {
+		return operand(r);
+	}
+
+	auto builder::get_operand(const imm& i) -> operand {
+		return operand(i);
+	}
+
+	auto builder::get_operand(label target) const -> operand {
+		return operand(m_labels[target.index].name);
+	}
+} // namespace baremetal::assembler
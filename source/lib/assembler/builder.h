@@ -0,0 +1,334 @@
+// programmatic interface to the assembler, builds a module from typed operands directly, without
+// printing assembly text and parsing it back through the lexer and the frontend.
+//
+// every mnemonic has a member function (generated in tools/scripts/tablegen.js), which accepts
+// registers (reg64, xmm, ...), memory operands (m8, m64, ...), immediates (imm, or any integer) and
+// label handles, ie.
+//
+//   builder b;
+//   const label loop = b.create_label("loop");
+//
+//   TRY(b.bind(loop));
+//   TRY(b.add(reg64(rax), m64(ptr(reg64(rsp), 8))));
+//   TRY(b.sub(reg64(rcx), 1));
+//   TRY(b.jnz(loop));
+//
+// the instruction is selected the same way, and staged the same way, as the frontend would for the
+// equivalent line of assembly, hence the resulting module is identical. masks and broadcasts are
+// only supported by the frontend.
+//
+// the types of registers, immediates and labels are known at compile time, hence so are the
+// variants which can match them. calls whose operands are all of these are selected at compile
+// time (see detail::select_static), and their size is computed by the encoder specialization of
+// the selected encoding. memory operands are only typed at runtime, and go through the index.
+
+#pragma once
+#include "assembler/ir/module.h"
+#include "assembler/backend.h"
+
+namespace baremetal::assembler {
+	struct label {
+		u32 index; // index of the label within its builder
+	};
+
+	namespace detail {
+		enum static_match : u8 {
+			MATCH_NEVER,
+			MATCH_MAYBE, // depends on the value of the operand (ie. 'rax' specific variants)
+			MATCH_ALWAYS
+		};
+
+		enum selection_kind : u8 {
+			SELECTION_DYNAMIC,    // some operand types are only known at runtime
+			SELECTION_CANDIDATES, // the candidates are matched at runtime, in database order
+			SELECTION_STATIC      // the first candidate is always selected
+		};
+
+		struct static_selection {
+			static constexpr u8 MAX_CANDIDATES = 8;
+
+			selection_kind kind;
+			u8 count;                    // number of candidates
+			u32 indices[MAX_CANDIDATES]; // INSTRUCTION_DB indices, in database order
+			u32 direct;                  // variant which encodes a static selection, see get_static_direct
+		};
+
+		// operand type of a builder argument, OP_HIDDEN for labels, OP_NONE if the type is only
+		// known at runtime (memory operands, registers which are typed on construction)
+		template<typename type>
+		constexpr auto get_static_operand_type() -> operand_type {
+			if constexpr(std::is_base_of_v<reg, type> && std::is_constructible_v<type, u8>) {
+				return static_cast<operand_type>(type(0).type);
+			}
+			else if constexpr(std::is_integral_v<type> || std::is_same_v<type, imm>) {
+				return OP_I64;
+			}
+			else if constexpr(std::is_same_v<type, label>) {
+				return OP_HIDDEN;
+			}
+			else {
+				return OP_NONE;
+			}
+		}
+
+		// compile time version of is_operand_match, assumes valid register indices (general purpose
+		// registers below 16)
+		constexpr auto get_static_match(operand_type variant, operand_type type, bool evex) -> static_match {
+			if(type == OP_I64 || type == OP_HIDDEN) {
+				return variant == type || is_operand_imm(variant) || is_operand_rel(variant) ? MATCH_ALWAYS : MATCH_NEVER;
+			}
+
+			switch(variant) {
+				case OP_FS:
+				case OP_GS:  return type == OP_SREG ? MATCH_MAYBE : MATCH_NEVER;
+				case OP_AL:
+				case OP_CL:  return type == OP_R8 ? MATCH_MAYBE : MATCH_NEVER;
+				case OP_AX:
+				case OP_DX:  return type == OP_R16 ? MATCH_MAYBE : MATCH_NEVER;
+				case OP_EAX:
+				case OP_ECX: return type == OP_R32 ? MATCH_MAYBE : MATCH_NEVER;
+				case OP_RAX:
+				case OP_RCX: return type == OP_R64 ? MATCH_MAYBE : MATCH_NEVER;
+				case OP_ST0: return type == OP_ST ? MATCH_MAYBE : MATCH_NEVER;
+				default:     break;
+			}
+
+			if(variant != type) {
+				return MATCH_NEVER;
+			}
+
+			// vector registers above 15 can only be encoded by EVEX variants
+			if(!evex && (type == OP_XMM || type == OP_YMM || type == OP_ZMM)) {
+				return MATCH_MAYBE;
+			}
+
+			return MATCH_ALWAYS;
+		}
+
+		// compile time version of backend::get_instruction_direct for known operands, which have been
+		// retyped to the operands of the selected variant
+		constexpr auto get_static_direct(u32 index, u8 count) -> u32 {
+			const instruction& selected = INSTRUCTION_DB[index];
+
+			for(u32 i = index; i < INSTRUCTION_DB_SIZE && INSTRUCTION_DB[i].mnemonic == selected.mnemonic; ++i) {
+				const instruction& other = INSTRUCTION_DB[i];
+				bool same = other.operand_count == count;
+
+				for(u8 j = 0; j < count && same; ++j) {
+					same = other.operands[j] == selected.operands[j];
+				}
+
+				if(same) {
+					return i;
+				}
+			}
+
+			return utility::limits<u32>::max();
+		}
+
+		// walks the variants of the mnemonic the same way detail::select_instruction walks its
+		// candidates, variants which can't match the operand types are dropped, and so is everything
+		// past the first variant which always matches them
+		constexpr auto select_static(u16 mnemonic, const operand_type* types, u8 count) -> static_selection {
+			static_selection selection = {};
+			bool unknown = false;
+
+			selection.kind = SELECTION_CANDIDATES;
+			selection.direct = utility::limits<u32>::max();
+
+			for(u8 i = 0; i < count; ++i) {
+				if(types[i] == OP_NONE) {
+					selection.kind = SELECTION_DYNAMIC;
+					return selection;
+				}
+
+				unknown |= types[i] == OP_HIDDEN;
+			}
+
+			// variants are sorted by their mnemonic ID
+			u32 low = 0;
+			u32 high = INSTRUCTION_DB_SIZE;
+
+			while(low < high) {
+				const u32 middle = (low + high) / 2;
+
+				if(INSTRUCTION_DB[middle].mnemonic < mnemonic) {
+					low = middle + 1;
+				}
+				else {
+					high = middle;
+				}
+			}
+
+			for(u32 index = low; index < INSTRUCTION_DB_SIZE && INSTRUCTION_DB[index].mnemonic == mnemonic; ++index) {
+				const instruction& inst = INSTRUCTION_DB[index];
+				static_match match = MATCH_ALWAYS;
+
+				for(u8 i = 0; i < 4 && match != MATCH_NEVER; ++i) {
+					if(i >= count) {
+						// implicit tail, see is_implicit_tail
+						if(inst.operands[i] != OP_NONE && inst.operands[i] != OP_HIDDEN) {
+							match = MATCH_NEVER;
+						}
+					}
+					else if(get_operand_class(inst.operands[i]) != get_operand_class(types[i])) {
+						match = MATCH_NEVER; // different operand signature
+					}
+					else {
+						const static_match operand_match = get_static_match(inst.operands[i], types[i], inst.is_evex());
+						match = operand_match < match ? operand_match : match;
+					}
+				}
+
+				if(match == MATCH_NEVER) {
+					continue;
+				}
+
+				if(selection.count == static_selection::MAX_CANDIDATES) {
+					selection.kind = SELECTION_DYNAMIC;
+					return selection;
+				}
+
+				selection.indices[selection.count++] = index;
+
+				if(match == MATCH_ALWAYS) {
+					if(selection.count == 1) {
+						selection.kind = SELECTION_STATIC;
+
+						// symbolic operands are sized at runtime, see backend::compute_size
+						if(!unknown) {
+							selection.direct = get_static_direct(index, count);
+						}
+					}
+
+					break;
+				}
+			}
+
+			return selection;
+		}
+
+		template<typename... types>
+		constexpr auto select_static(u16 mnemonic) -> static_selection {
+			const operand_type static_types[] = { OP_NONE, get_static_operand_type<types>()... };
+			return select_static(mnemonic, static_types + 1, sizeof...(types));
+		}
+	} // namespace detail
+
+	// memory locations, the size of the location is specified by the operand functions below
+	[[nodiscard]] auto ptr(reg base, i32 displacement = 0) -> mem;
+	[[nodiscard]] auto ptr(reg base, reg index, scale s = SCALE_1, i32 displacement = 0) -> mem;
+
+	// memory operands, ie. m64(ptr(reg64(rsp), 8)) is equivalent to 'qword [rsp + 8]'
+	[[nodiscard]] auto m8(const mem& memory) -> operand;
+	[[nodiscard]] auto m16(const mem& memory) -> operand;
+	[[nodiscard]] auto m32(const mem& memory) -> operand;
+	[[nodiscard]] auto m64(const mem& memory) -> operand;
+	[[nodiscard]] auto m80(const mem& memory) -> operand;
+	[[nodiscard]] auto m128(const mem& memory) -> operand;
+	[[nodiscard]] auto m256(const mem& memory) -> operand;
+	[[nodiscard]] auto m512(const mem& memory) -> operand;
+
+	class builder {
+	public:
+		builder();
+
+		// the module references our context, hence we can't be moved around
+		builder(const builder&) = delete;
+		auto operator=(const builder&) -> builder& = delete;
+
+		// creates a new label, every label has to be bound exactly once before the module is finished
+		[[nodiscard]] auto create_label(const utility::string_view& name) -> label;
+		[[nodiscard]] auto create_label() -> label;
+
+		// binds the label to the current position in the current section
+		[[nodiscard]] auto bind(label target) -> utility::result<void>;
+
+		// exports the label, see jit_code::get_symbol
+		void global(label target);
+
+		void set_section(const utility::string_view& name);
+		void data(const u8* data, u64 size);
+
+		// commits the last instruction block and returns the finished module, which is only valid for
+		// as long as the builder is
+		[[nodiscard]] auto finish() -> utility::result<module>;
+
+		template<typename... types>
+		auto emit(u16 mnemonic, const types&... operands) -> utility::result<void> {
+			static_assert(sizeof...(types) <= 4, "too many operands specified");
+
+			const operand converted[] = { operand(), get_operand(operands)... };
+			return emit_instruction(mnemonic, converted + 1, sizeof...(types));
+		}
+
+		template<u16 mnemonic, typename... types>
+		auto emit(const types&... operands) -> utility::result<void> {
+			static_assert(sizeof...(types) <= 4, "too many operands specified");
+
+			constexpr u8 count = sizeof...(types);
+			constexpr detail::static_selection selection = detail::select_static<types...>(mnemonic);
+
+			const operand converted[] = { operand(), get_operand(operands)... };
+
+			if constexpr(selection.kind == detail::SELECTION_DYNAMIC) {
+				return emit_instruction(mnemonic, converted + 1, count);
+			}
+			else if constexpr(selection.kind == detail::SELECTION_CANDIDATES) {
+				return emit_candidates(selection.indices, selection.count, converted + 1, count);
+			}
+			else {
+				constexpr u32 index = selection.indices[0];
+				operand staged[4];
+
+				ASSERT(get_selection(mnemonic, converted + 1, count) == index, "static selection mismatch\n");
+				retype_operands(index, converted + 1, count, staged);
+
+				if constexpr(selection.direct == utility::limits<u32>::max()) {
+					push_instruction(index, staged, backend::compute_size(index, staged));
+				}
+				else {
+					constexpr const instruction* inst = &INSTRUCTION_DB[selection.direct];
+					push_instruction(index, staged, encoder(inst, staged).compute_size_specialized<inst->enc>());
+				}
+
+				return SUCCESS;
+			}
+		}
+
+		// one function per mnemonic, ie. add(...), mnemonics which aren't valid identifiers have a
+		// trailing underscore (and_, int_, not_, or_, xor_)
+		#include "assembler/instruction/databases/builder.inc"
+	private:
+		[[nodiscard]] auto emit_instruction(u16 mnemonic, const operand* operands, u8 count) -> utility::result<void>;
+		[[nodiscard]] auto emit_candidates(const u32* indices, u8 candidate_count, const operand* operands, u8 count) -> utility::result<void>;
+
+		[[nodiscard]] static auto get_selection(u16 mnemonic, const operand* operands, u8 count) -> u32;
+
+		// copies the operands into 'staged' and retypes them to the operands of the variant
+		static void retype_operands(u32 index, const operand* operands, u8 count, operand* staged);
+
+		void stage_instruction(u32 index, const operand* operands, u8 count);
+		void push_instruction(u32 index, const operand* staged, u8 size);
+
+		[[nodiscard]] static auto get_operand(const operand& op) -> operand;
+		[[nodiscard]] static auto get_operand(const reg& r) -> operand;
+		[[nodiscard]] static auto get_operand(const imm& i) -> operand;
+		[[nodiscard]] auto get_operand(label target) const -> operand;
+
+		template<typename type> requires std::is_integral_v<type>
+		[[nodiscard]] static auto get_operand(type value) -> operand {
+			return operand(imm(value));
+		}
+	private:
+		struct label_info {
+			utility::string_view* name;
+			bool bound;
+		};
+
+		context m_context;
+		module m_module;
+
+		utility::dynamic_array<label_info> m_labels;
+	};
+} // namespace baremetal::assembler
@@ -0,0 +1,731 @@
+#include "./decoder.h"
+#include "assembler/backend.h"
+
+namespace baremetal::assembler {
+	namespace detail {
+		// DECODER_TABLE and DECODER_DB
+		#include "assembler/instruction/databases/decoder.inc"
+
+		static_assert(sizeof(DECODER_TABLE) / sizeof(opcode_range) == MAP_COUNT * 256, "decoder table size mismatch");
+		static_assert(sizeof(DECODER_DB) / sizeof(u16) <= utility::limits<u16>::max(), "magic number limit reached");
+
+		constexpr u8 NO_OPERAND = utility::limits<u8>::max();
+
+		// applies a legacy prefix byte to a prefix bitboard, returns false if the byte isn't a prefix
+		auto apply_legacy_prefix(u8 byte, u8& prefix) -> bool {
+			switch(byte) {
+				// group 1
+				case 0xF0: prefix = (prefix & 0b11111100) | LOCK;  return true;
+				case 0xF2: prefix = (prefix & 0b11111100) | REPNE; return true;
+				case 0xF3: prefix = (prefix & 0b11111100) | REP;   return true;
+				// group 2
+				case 0x2E: prefix = (prefix & 0b11000011) | CS_SEGMENT; return true;
+				case 0x36: prefix = (prefix & 0b11000011) | SS_SEGMENT; return true;
+				case 0x3E: prefix = (prefix & 0b11000011) | DS_SEGMENT; return true;
+				case 0x26: prefix = (prefix & 0b11000011) | ES_SEGMENT; return true;
+				case 0x64: prefix = (prefix & 0b11000011) | FS_SEGMENT; return true;
+				case 0x65: prefix = (prefix & 0b11000011) | GS_SEGMENT; return true;
+				// group 3
+				case 0x66: prefix |= OPERAND_SIZE_OVERRIDE; return true;
+				// group 4
+				case 0x67: prefix |= ADDRESS_SIZE_OVERRIDE; return true;
+				default:   return false;
+			}
+		}
+
+		// number of opcode bytes the encoder emits for a legacy instruction, including escape bytes
+		auto get_legacy_opcode_size(const instruction& inst) -> u8 {
+			if(inst.enc == ENC_NORMALD) {
+				return 1; // the first instruction is decoded as a prefix
+			}
+
+			u8 size = 1;
+
+			for(u8 i = 1; i < 4; ++i) {
+				size += ((inst.opcode >> (i * 8)) & 0xff) != 0;
+			}
+
+			return size;
+		}
+
+		auto get_escape_size(opcode_map map) -> u8 {
+			switch(map) {
+				case MAP_LEGACY_0F:   return 1;
+				case MAP_LEGACY_0F38:
+				case MAP_LEGACY_0F3A: return 2;
+				default:              return 0;
+			}
+		}
+
+		// masked EVEX memory operands without a base swap the roles of the modR/M fields
+		auto is_evex_swapped(const instruction& inst, const mem& memory) -> bool {
+			if(inst.operand_count != 2) {
+				return false;
+			}
+
+			if(
+				is_operand_reg(inst.operands[0]) &&
+				is_operand_reg(inst.operands[1]) &&
+				inst.has_masked_operand() == false
+			) {
+				return true;
+			}
+
+			return inst.has_masked_operand() && is_operand_mem(inst.operands[0]) && memory.has_base == false;
+		}
+
+		// operand encoded in the reg field of the modR/M byte, mirrors encoder::get_modrm_reg
+		auto get_modrm_reg_operand(const instruction& inst, const mem& memory) -> u8 {
+			switch(inst.enc) {
+				case ENC_EVEX_RVM: return is_evex_swapped(inst, memory) ? 1 : 0;
+				case ENC_EVEX_MR: {
+					if(
+						is_operand_mem(inst.operands[1]) ||
+						(is_operand_reg(inst.operands[0]) && inst.has_masked_operand())
+					) {
+						return 0;
+					}
+
+					return 1;
+				}
+				case ENC_VEX_RVMS:
+				case ENC_VEX_RVMN:
+				case ENC_RM:
+				case ENC_VEX_RVM:
+				case ENC_EVEX_RMZ:
+				case ENC_EVEX_RM:
+				case ENC_VEX_R:
+				case ENC_VEX_RMV:
+				case ENC_VEX_RM:   return 0;
+				case ENC_VEX:
+				case ENC_VEX_MVR:
+				case ENC_VEX_MR:
+				case ENC_EVEX_MVR:
+				case ENC_MR:
+				case ENC_RMR:      return 1;
+				case ENC_VEX_MVRR:
+				case ENC_EVEX_VM:  return 2;
+				default:           return NO_OPERAND;
+			}
+		}
+
+		// operand encoded in the rm field of the modR/M byte (or in the opcode itself), mirrors
+		// encoder::get_modrm_rm
+		auto get_modrm_rm_operand(const instruction& inst, const mem& memory) -> u8 {
+			switch(inst.enc) {
+				case ENC_NORMAL: {
+					switch(inst.operands[0]) {
+						case OP_AX:
+						case OP_EAX:
+						case OP_RAX:
+						case OP_ST0: return 1;
+						default:     return 0;
+					}
+				}
+				case ENC_EVEX_RVM: {
+					if(inst.operand_count != 2) {
+						return 2;
+					}
+
+					return is_evex_swapped(inst, memory) ? 0 : 1;
+				}
+				case ENC_EVEX_RMZ:
+				case ENC_EVEX_RM: {
+					if(
+						inst.operand_count == 2 ||
+						(inst.operand_count == 3 && !(is_operand_mem(inst.operands[2]) || is_operand_reg(inst.operands[2])))
+					) {
+						return 1;
+					}
+
+					return 2;
+				}
+				case ENC_EVEX_MR: {
+					if(
+						is_operand_mem(inst.operands[1]) ||
+						(is_operand_reg(inst.operands[0]) && inst.has_masked_operand())
+					) {
+						return 1;
+					}
+
+					return 0;
+				}
+				case ENC_VEX_MR:
+				case ENC_XOP:
+				case ENC_EVEX_MVR:
+				case ENC_NORMALD:
+				case ENC_MR:
+				case ENC_M:
+				case ENC_RMR:
+				case ENC_R:
+				case ENC_VEX:
+				case ENC_VEX_MVRR:
+				case ENC_VEX_MVR:  return 0;
+				case ENC_VEX_RVMN:
+				case ENC_VEX_RM:
+				case ENC_RM:
+				case ENC_VEX_VM:
+				case ENC_XOP_VM:
+				case ENC_VEX_RMV:
+				case ENC_EVEX_VM:  return 1;
+				case ENC_VEX_RVMS:
+				case ENC_VEX_RVM:  return 2;
+				default:           return NO_OPERAND;
+			}
+		}
+
+		// operand encoded in the vvvv field of the VEX/XOP/EVEX prefix, mirrors encoder::get_extending_reg
+		auto get_vvvv_operand(const instruction& inst) -> u8 {
+			switch(inst.enc) {
+				case ENC_VEX_VM:
+				case ENC_EVEX_RMZ:
+				case ENC_XOP_VM:
+				case ENC_EVEX_VM:   return 0;
+				case ENC_VEX_RVM:
+				case ENC_VEX_RVMS:
+				case ENC_VEX_MVRR:
+				case ENC_EVEX_MVR:  return 1;
+				case ENC_VEX:
+				case ENC_VEX_RMV:
+				case ENC_VEX_MVR:   return 2;
+				case ENC_EVEX_RVM:  return inst.operand_count == 2 ? NO_OPERAND : 1;
+				case ENC_EVEX_RM: {
+					if(
+						(inst.operand_count == 3 && is_operand_imm(inst.operands[2]) == false) ||
+						(inst.operand_count == 4 && is_operand_imm(inst.operands[3]))
+					) {
+						return 1;
+					}
+
+					return NO_OPERAND;
+				}
+				default: return NO_OPERAND;
+			}
+		}
+
+		// registers which are implied by the operand type, these aren't encoded anywhere
+		auto is_fixed_register(operand_type type) -> bool {
+			switch(type) {
+				case OP_AL:
+				case OP_CL:
+				case OP_AX:
+				case OP_DX:
+				case OP_EAX:
+				case OP_ECX:
+				case OP_EDX:
+				case OP_RAX:
+				case OP_RCX:
+				case OP_ST0:
+				case OP_ES:
+				case OP_CS:
+				case OP_SS:
+				case OP_DS:
+				case OP_FS:
+				case OP_GS: return true;
+				default:    return false;
+			}
+		}
+
+		auto get_fixed_register(operand_type type) -> u8 {
+			switch(type) {
+				case OP_CL:
+				case OP_ECX:
+				case OP_RCX: return rcx;
+				case OP_DX:
+				case OP_EDX: return dx;
+				case OP_CS:  return 1;
+				case OP_SS:  return 2;
+				case OP_DS:  return 3;
+				case OP_FS:  return fs;
+				case OP_GS:  return gs;
+				default:     return rax; // al, ax, eax, rax, st0 and es
+			}
+		}
+
+		// type of the index register of VSIB memory operands, REG_NONE for regular memory operands
+		auto get_vsib_index_type(operand_type type) -> reg_type {
+			switch(type) {
+				case OP_VM32X:
+				case OP_VM64X:
+				case OP_VM32X_K:
+				case OP_VM64X_K: return REG_XMM;
+				case OP_VM32Y:
+				case OP_VM64Y:
+				case OP_VM32Y_K:
+				case OP_VM64Y_K: return REG_YMM;
+				case OP_VM32Z:
+				case OP_VM64Z:
+				case OP_VM32Z_K:
+				case OP_VM64Z_K: return REG_ZMM;
+				default:         return REG_NONE;
+			}
+		}
+	} // namespace detail
+
+	decoder::decoder(const u8* data, u64 size) : m_data(data), m_size(size) {}
+
+	auto decoder::decode(unpacked_instruction& output) -> u8 {
+		if(m_position >= m_size) {
+			return 0;
+		}
+
+		const u64 available = m_size - m_position;
+
+		m_bytes = m_data + m_position;
+		m_available = available < MAX_INSTRUCTION_SIZE ? static_cast<u8>(available) : MAX_INSTRUCTION_SIZE;
+
+		u8 size = 0;
+
+		// the first instruction of a double instruction (fwait) precedes the prefixes of the second one,
+		// hence we treat it as a prefix first, and as a separate instruction if that doesn't work out
+		if(m_bytes[0] == 0x9b && decode_prefixes(1)) {
+			size = decode_opcode(output);
+		}
+
+		if(size == 0 && decode_prefixes(0)) {
+			size = decode_opcode(output);
+		}
+
+		m_position += size;
+		return size;
+	}
+
+	auto decoder::get_position() const -> u64 {
+		return m_position;
+	}
+
+	auto decoder::decode_opcode(unpacked_instruction& output) -> u8 {
+		// candidates are sorted by their opcode length and then by their position in the database,
+		// the first one which matches wins
+		const opcode_range& range = detail::DECODER_TABLE[m_map * 256 + m_bytes[m_opcode]];
+
+		for(u16 i = range.first; i < range.first + range.count; ++i) {
+			const u8 size = decode_candidate(detail::DECODER_DB[i], output);
+
+			if(size != 0) {
+				return size;
+			}
+		}
+
+		return 0;
+	}
+
+	auto decoder::decode_prefixes(u8 position) -> bool {
+		m_wait = position != 0;
+		m_prefix = 0;
+		m_rex = false;
+		m_map = MAP_LEGACY;
+		m_w = m_r = m_x = m_b = m_r2 = m_v2 = 0;
+		m_vvvv = m_l = m_pp = 0;
+		m_zero = m_broadcast = m_mask = 0;
+
+		// legacy prefixes
+		while(position < m_available && detail::apply_legacy_prefix(m_bytes[position], m_prefix)) {
+			position++;
+		}
+
+		if(position >= m_available) {
+			return false;
+		}
+
+		const u8 byte = m_bytes[position];
+
+		if((byte & 0xf0) == 0x40) {
+			// REX prefix [0100WRXB]
+			m_rex = true;
+			m_w = (byte >> 3) & 1;
+			m_r = (byte >> 2) & 1;
+			m_x = (byte >> 1) & 1;
+			m_b = byte & 1;
+			position++;
+		}
+		else if(byte == 0xc5) {
+			// two byte VEX prefix
+			if(position + 2 >= m_available) {
+				return false;
+			}
+
+			const u8 prefix = m_bytes[position + 1];
+
+			m_r = !(prefix & 0b10000000);        // ~R    [X_______]
+			m_vvvv = (~prefix >> 3) & 0b1111;    // ~vvvv [_XXXX___]
+			m_l = (prefix >> 2) & 1;             // L     [_____X__]
+			m_pp = prefix & 0b11;                // IMP   [______XX]
+			m_map = MAP_VEX_0F;
+			position += 2;
+		}
+		else if(
+			byte == 0xc4 ||
+			(byte == 0x8f && position + 1 < m_available && (m_bytes[position + 1] & 0b00011111) >= 8)
+		) {
+			// three byte VEX prefix, or a XOP prefix (8f /0 is a pop, which never uses maps above 7)
+			if(position + 3 >= m_available) {
+				return false;
+			}
+
+			const u8 prefix[2] = { m_bytes[position + 1], m_bytes[position + 2] };
+
+			m_r = !(prefix[0] & 0b10000000);     // ~R         [X_______]
+			m_x = !(prefix[0] & 0b01000000);     // ~X         [_X______]
+			m_b = !(prefix[0] & 0b00100000);     // ~B         [__X_____]
+
+			switch((byte << 8) | (prefix[0] & 0b00011111)) {
+				case 0xc401: m_map = MAP_VEX_0F;   break;
+				case 0xc402: m_map = MAP_VEX_0F38; break;
+				case 0xc403: m_map = MAP_VEX_0F3A; break;
+				case 0x8f09: m_map = MAP_XOP_9;    break;
+				case 0x8f0a: m_map = MAP_XOP_A;    break;
+				default:     return false;
+			}
+
+			m_w = prefix[1] >> 7;                // W/E        [X_______]
+			m_vvvv = (~prefix[1] >> 3) & 0b1111; // ~vvvv      [_XXXX___]
+			m_l = (prefix[1] >> 2) & 1;          // L          [_____X__]
+			m_pp = prefix[1] & 0b11;             // pp         [______XX]
+			position += 3;
+		}
+		else if(byte == 0x62) {
+			// EVEX prefix
+			if(position + 4 >= m_available) {
+				return false;
+			}
+
+			const u8 prefix[3] = { m_bytes[position + 1], m_bytes[position + 2], m_bytes[position + 3] };
+
+			m_r = !(prefix[0] & 0b10000000);     // ~R         [X_______]
+			m_x = !(prefix[0] & 0b01000000);     // ~X         [_X______]
+			m_b = !(prefix[0] & 0b00100000);     // ~B         [__X_____]
+			m_r2 = !(prefix[0] & 0b00010000);    // ~R'        [___X____]
+
+			switch(prefix[0] & 0b00000111) {     // map select [_____XXX]
+				case 1:  m_map = MAP_EVEX_0F;   break;
+				case 2:  m_map = MAP_EVEX_0F38; break;
+				case 3:  m_map = MAP_EVEX_0F3A; break;
+				case 5:  m_map = MAP_EVEX_5;    break;
+				case 6:  m_map = MAP_EVEX_6;    break;
+				default: return false;
+			}
+
+			m_w = prefix[1] >> 7;                // W          [X_______]
+			m_vvvv = (~prefix[1] >> 3) & 0b1111; // ~VVVV      [_XXXX___]
+			m_pp = prefix[1] & 0b11;             // IMP        [______XX]
+
+			m_zero = prefix[2] >> 7;             // zero mask  [X_______]
+			m_l = (prefix[2] >> 5) & 0b11;       // size       [_XX_____]
+			m_broadcast = (prefix[2] >> 4) & 1;  // broadcast  [___X____]
+			m_v2 = !(prefix[2] & 0b00001000);    // ~V         [____X___]
+			m_mask = prefix[2] & 0b00000111;     // mask       [_____XXX]
+			position += 4;
+		}
+
+		// legacy escape bytes
+		if(m_map == MAP_LEGACY && position < m_available && m_bytes[position] == 0x0f) {
+			const u8 next = position + 1 < m_available ? m_bytes[position + 1] : 0;
+
+			switch(next) {
+				case 0x38: m_map = MAP_LEGACY_0F38; position += 2; break;
+				case 0x3a: m_map = MAP_LEGACY_0F3A; position += 2; break;
+				default:   m_map = MAP_LEGACY_0F;   position += 1; break;
+			}
+		}
+
+		if(position >= m_available) {
+			return false;
+		}
+
+		m_opcode = position;
+		return true;
+	}
+
+	auto decoder::is_matching_variant(const instruction& inst) const -> bool {
+		if(inst.is_rex()) {
+			// mandatory prefixes, the remaining ones depend on the operands
+			constexpr u8 mandatory = OPERAND_SIZE_OVERRIDE | 0b00000011;
+
+			return
+				m_w == inst.is_rexw() &&
+				(m_prefix & mandatory) == (inst.prefix & mandatory) &&
+				m_wait == (inst.enc == ENC_NORMALD);
+		}
+
+		// VEX/XOP/EVEX instructions never have legacy prefixes
+		if(m_wait || m_prefix != 0 || m_w != inst.is_rexw() || m_pp != inst.get_additional_prefix()) {
+			return false;
+		}
+
+		if(inst.is_vex_xop()) {
+			return m_l == inst.get_vector_length();
+		}
+
+		return
+			m_l == (inst.get_evex_operand_type() >> 5) &&
+			m_zero == inst.get_evex_zero() &&
+			m_broadcast == inst.has_broadcast_operand() &&
+			(m_mask == 0 || inst.has_masked_operand());
+	}
+
+	auto decoder::decode_candidate(u32 index, unpacked_instruction& output) -> u8 {
+		const instruction& inst = INSTRUCTION_DB[index];
+
+		if(is_matching_variant(inst) == false) {
+			return 0;
+		}
+
+		// last opcode byte, legacy opcodes can continue past the byte we've looked the candidates up by
+		// (ie. x87 register forms, or instructions composed of two instructions)
+		u8 opcode = m_opcode;
+
+		if(inst.is_rex()) {
+			opcode += detail::get_legacy_opcode_size(inst) - detail::get_escape_size(m_map) - 1;
+		}
+
+		if(opcode >= m_available) {
+			return 0;
+		}
+
+		u8 position = opcode + 1;
+
+		// locate the memory operand, there's at most one and it's never the last operand
+		u8 memory_index = detail::NO_OPERAND;
+
+		for(u8 i = 0; i < 3; ++i) {
+			if(is_operand_mem(inst.operands[i])) {
+				memory_index = i;
+				break;
+			}
+		}
+
+		// modR/M, SIB
+		u8 modrm = 0;
+		u8 displacement_size = 0;
+		mem memory;
+
+		if(memory_index != detail::NO_OPERAND || inst.has_broadcast_operand() || inst.is_r() || inst.is_rm()) {
+			if(position >= m_available) {
+				return 0;
+			}
+
+			modrm = m_bytes[position++];
+			const u8 mod = modrm >> 6;
+
+			// opcode extension
+			if(inst.is_rm() && !inst.is_is4() && ((modrm >> 3) & 0b111) != inst.get_rm()) {
+				return 0;
+			}
+
+			if(memory_index != detail::NO_OPERAND) {
+				if(mod == detail::DIRECT || !decode_memory(inst.operands[memory_index], position, memory)) {
+					return 0;
+				}
+
+				if(mod == detail::INDIRECT_DISP8) {
+					displacement_size = 1;
+				}
+				else if(mod == detail::INDIRECT_DISP32 || memory.has_base == false || memory.base.type == REG_RIP) {
+					displacement_size = 4;
+				}
+			}
+			else if(mod != (inst.has_broadcast_operand() ? detail::INDIRECT : detail::DIRECT)) {
+				return 0; // broadcasts carry no address
+			}
+		}
+
+		utility::memset(output.operands, 0, sizeof(operand) * 4);
+
+		// displacements and immediates, in operand order
+		for(u8 i = 0; i < inst.operand_count; ++i) {
+			const operand_type type = inst.operands[i];
+			operand& op = output.operands[i];
+
+			op.type = type;
+
+			if(is_operand_imm(type) || is_operand_rel(type)) {
+				const u8 size = static_cast<u8>(get_operand_bit_width(type) / 8);
+
+				if(position + size > m_available) {
+					return 0;
+				}
+
+				const u64 value = read(position, size);
+				position += size;
+
+				if(is_operand_rel(type)) {
+					op.immediate = imm(static_cast<i64>(detail::sign_extend(value, size * 8)));
+				}
+				else {
+					op.immediate = imm(value);
+				}
+			}
+			else if(is_operand_moff(type)) {
+				if(position + 8 > m_available) {
+					return 0;
+				}
+
+				op.memory_offset = moff(read(position, 8));
+				position += 8;
+			}
+			else if(i == memory_index) {
+				if(position + displacement_size > m_available) {
+					return 0;
+				}
+
+				if(displacement_size != 0) {
+					const u64 value = read(position, displacement_size);
+					memory.displacement = imm(static_cast<i64>(detail::sign_extend(value, displacement_size * 8)));
+					position += displacement_size;
+
+					// 32-bit displacements which would fit into 8 bits (ie. symbolic ones) stay 32 bits wide
+					if(displacement_size == 4) {
+						memory.displacement.min_bits = 32;
+					}
+				}
+				else {
+					memory.displacement = imm(static_cast<u64>(0));
+				}
+
+				op.memory = memory;
+
+				if(is_operand_masked(type)) {
+					op.mm.k = m_mask;
+				}
+			}
+			else if(type == OP_HIDDEN) {
+				op.immediate = imm(static_cast<u64>(1));
+			}
+		}
+
+		// trailing register encoded as an immediate
+		u8 is4 = 0;
+
+		if(inst.is_is4()) {
+			if(position >= m_available) {
+				return 0;
+			}
+
+			is4 = m_bytes[position++] >> 4;
+		}
+
+		// registers
+		const u8 reg_operand = detail::get_modrm_reg_operand(inst, memory);
+		const u8 rm_operand = detail::get_modrm_rm_operand(inst, memory);
+		const u8 vvvv_operand = detail::get_vvvv_operand(inst);
+		const u8 rm_extension = inst.is_evex() ? m_x << 4 : 0; // EVEX registers above 15 use X
+
+		for(u8 i = 0; i < inst.operand_count; ++i) {
+			operand& op = output.operands[i];
+
+			if(is_operand_reg(op.type) == false) {
+				continue;
+			}
+
+			if(detail::is_fixed_register(op.type)) {
+				op.r = detail::get_fixed_register(op.type);
+			}
+			else if(inst.is_is4() && i == 3) {
+				op.r = is4;
+			}
+			else if(i == reg_operand) {
+				op.r = static_cast<u8>(((modrm >> 3) & 0b111) | m_r << 3 | m_r2 << 4);
+			}
+			else if(i == rm_operand && inst.is_ri()) {
+				op.r = static_cast<u8>((m_bytes[opcode] & 0b111) | m_b << 3);
+			}
+			else if(i == rm_operand) {
+				op.r = static_cast<u8>((modrm & 0b111) | m_b << 3 | rm_extension);
+			}
+			else if(i == vvvv_operand) {
+				op.r = static_cast<u8>(m_vvvv | m_v2 << 4);
+			}
+			else {
+				return 0;
+			}
+
+			if(is_operand_masked(op.type)) {
+				op.mr.k = m_mask;
+			}
+		}
+
+		// rip relative displacements are stored relative to the start of the instruction
+		if(memory_index != detail::NO_OPERAND && memory.base.type == REG_RIP) {
+			imm& displacement = output.operands[memory_index].memory.displacement;
+			displacement = imm(static_cast<i64>(displacement.value) + position);
+		}
+
+		// verify that the candidate encodes into the exact same bytes
+		u8 encoded[MAX_INSTRUCTION_SIZE];
+
+		if(encoder(&inst, output.operands).emit(encoded) != position) {
+			return 0;
+		}
+
+		for(u8 i = 0; i < position; ++i) {
+			if(encoded[i] != m_bytes[i]) {
+				return 0;
+			}
+		}
+
+		output.index = index;
+		output.size = position;
+
+		return position;
+	}
+
+	auto decoder::decode_memory(operand_type type, u8& position, mem& memory) const -> bool {
+		const u8 modrm = m_bytes[position - 1];
+		const u8 mod = modrm >> 6;
+		const u8 rm = modrm & 0b111;
+		const reg_type address = (m_prefix & ADDRESS_SIZE_OVERRIDE) ? REG_R32 : REG_R64;
+		const reg_type vsib = detail::get_vsib_index_type(type);
+
+		if(rm == 0b100) {
+			// SIB
+			if(position >= m_available) {
+				return false;
+			}
+
+			const u8 sib = m_bytes[position++];
+			const u8 index = static_cast<u8>(((sib >> 3) & 0b111) | m_x << 3);
+			const u8 base = static_cast<u8>((sib & 0b111) | m_b << 3);
+
+			memory.s = static_cast<scale>(sib >> 6);
+
+			if(vsib != REG_NONE) {
+				memory.has_index = true;
+				memory.index = reg(static_cast<u8>(index | m_v2 << 4), vsib);
+			}
+			else if(index != 0b100) {
+				memory.has_index = true;
+				memory.index = reg(index, address);
+			}
+
+			// absolute address
+			if((base & 0b111) == 0b101 && mod == detail::INDIRECT) {
+				return true;
+			}
+
+			memory.has_base = true;
+			memory.base = reg(base, address);
+			return true;
+		}
+
+		memory.has_base = true;
+
+		if(rm == 0b101 && mod == detail::INDIRECT) {
+			memory.base = rip;
+			return true;
+		}
+
+		memory.base = reg(static_cast<u8>(rm | m_b << 3), address);
+		return true;
+	}
+
+	auto decoder::read(u8 position, u8 size) const -> u64 {
+		u64 value = 0;
+
+		for(u8 i = 0; i < size; ++i) {
+			value |= static_cast<u64>(m_bytes[position + i]) << (i * 8);
+		}
+
+		return value;
+	}
+} // namespace baremetal::assembler
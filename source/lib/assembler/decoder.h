@@ -0,0 +1,87 @@
+// table driven x64 decoder, turns encoded instructions back into INSTRUCTION_DB variants and their
+// operands, the inverse of the encoder in lib/assembler/backend.cpp.
+//
+// every opcode map (legacy, 0F, 0F38, 0F3A and the VEX, XOP and EVEX maps) has a table, generated
+// in tools/scripts/tablegen.js, which maps an opcode byte to a list of candidate variants. once the
+// prefixes are decoded, we walk the candidates of the opcode byte, skip the ones whose fixed fields
+// (mandatory prefixes, W, L, opcode extension, ...) don't match, and decode the operands of the
+// remaining ones. the database contains variants which differ only in the way the encoder treats
+// them, hence a candidate is only accepted if encoding its operands yields the exact same bytes.
+
+#pragma once
+#include "assembler/ir/module.h"
+
+namespace baremetal::assembler {
+	// has to match decoder_maps in tools/scripts/tablegen.js
+	enum opcode_map : u8 {
+		MAP_LEGACY,
+		MAP_LEGACY_0F,
+		MAP_LEGACY_0F38,
+		MAP_LEGACY_0F3A,
+		MAP_VEX_0F,
+		MAP_VEX_0F38,
+		MAP_VEX_0F3A,
+		MAP_XOP_9,
+		MAP_XOP_A,
+		MAP_EVEX_0F,
+		MAP_EVEX_0F38,
+		MAP_EVEX_0F3A,
+		MAP_EVEX_5,
+		MAP_EVEX_6,
+		MAP_COUNT
+	};
+
+	struct opcode_range {
+		u16 first; // offset of the first candidate in DECODER_DB
+		u8 count;  // number of candidates
+	};
+
+	class decoder {
+	public:
+		decoder(const u8* data, u64 size);
+
+		// decodes the next instruction into 'output' and moves past it, returns the size of the
+		// instruction, or 0 if there are no bytes left or if they don't form a known instruction
+		auto decode(unpacked_instruction& output) -> u8;
+		[[nodiscard]] auto get_position() const -> u64;
+	private:
+		// decodes everything up to the opcode byte, starting at 'position', false if the bytes are invalid
+		auto decode_prefixes(u8 position) -> bool;
+		auto decode_opcode(unpacked_instruction& output) -> u8;
+		auto decode_candidate(u32 index, unpacked_instruction& output) -> u8;
+		auto decode_memory(operand_type type, u8& position, mem& memory) const -> bool;
+
+		// checks the fields which are fixed for every variant (prefixes, W, L, ...)
+		[[nodiscard]] auto is_matching_variant(const instruction& inst) const -> bool;
+
+		[[nodiscard]] auto read(u8 position, u8 size) const -> u64;
+	private:
+		const u8* m_data;
+		u64 m_size;
+		u64 m_position = 0;
+
+		// current instruction
+		const u8* m_bytes = nullptr;
+		u8 m_available = 0;   // bytes available to the current instruction
+
+		bool m_wait = false;  // first instruction of a double instruction
+		u8 m_prefix = 0;      // legacy prefixes, see prefix
+		bool m_rex = false;   // REX prefix present
+		opcode_map m_map = MAP_LEGACY;
+		u8 m_opcode = 0;      // position of the opcode byte
+
+		// REX/VEX/XOP/EVEX fields, already inverted where the prefix stores them inverted
+		u8 m_w = 0;
+		u8 m_r = 0;
+		u8 m_x = 0;
+		u8 m_b = 0;
+		u8 m_r2 = 0;          // EVEX.R'
+		u8 m_v2 = 0;          // EVEX.V'
+		u8 m_vvvv = 0;
+		u8 m_l = 0;           // VEX.L or EVEX.L'L
+		u8 m_pp = 0;
+		u8 m_zero = 0;        // EVEX.z
+		u8 m_broadcast = 0;   // EVEX.b
+		u8 m_mask = 0;        // EVEX.aaa
+	};
+} // namespace baremetal::assembler
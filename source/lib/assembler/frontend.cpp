@@ -3,12 +3,16 @@
 
 #include <utility/system/file.h>
 
+#include "assembler/ir/module_log.h"
 #include "assembler/ir/module.h"
-#include "assembler/lexer.h"
+#include "assembler/token_stream.h"
+
+#include <atomic>
+#include <thread>
 
 #define EXPECT_TOKEN(expected)                                    \
   do {                                                            \
-    if(m_lexer.current != expected) {                             \
+    if(m_tokens.current != expected) {                             \
       return utility::error("[PASS 1]unexpected token received"); \
     }                                                             \
   }                                                               \
@@ -88,7 +92,7 @@ namespace baremetal::assembler {
 			}
 		}
 
-		auto is_operand_match(const instruction& inst, operand* operands, u8 broadcast_n, u8 count) -> bool {
+		auto is_operand_match(const instruction_selection& inst, const operand* operands, u8 broadcast_n, u8 count) -> bool {
 			for(u8 i = 0; i < count; ++i) {
 				const operand_type left = inst.operands[i];
 				const operand_type right = operands[i].type;
@@ -105,33 +109,293 @@ namespace baremetal::assembler {
 					return false;
 				}
 
-				if(is_operand_reg(right) && operands[i].r > 15 && !inst.is_evex()) {
+				if(is_operand_reg(right) && operands[i].r > 15 && !inst.evex) {
 					return false;
 				}
 
-				if(
-					inst.has_broadcast_operand() &&
-					broadcast_to_bits(inst.operands[inst.get_broadcast_operand()]) * broadcast_n != inst_size_to_int(inst.op_size)
-				) {
-return false;
+				if(inst.broadcast_n != 0 && inst.broadcast_n != broadcast_n) {
+					return false;
 				}
 			}
 	
 			return true;
 		}
+
+		[[nodiscard]] auto is_implicit_tail(const instruction_selection& inst, u8 count) -> bool {
+			for(u8 i = count; i < 4; ++i) {
+				if(inst.operands[i] != OP_NONE && inst.operands[i] != OP_HIDDEN) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		auto select_instruction(u16 mnemonic, const operand* operands, u8 count, u8 broadcast_n) -> u32 {
+			// only variants whose operand signature matches ours are checked
+			const u32 signature = get_operand_signature(operands, count);
+			const instruction_candidates candidates = get_instruction_candidates(mnemonic, signature);
+			instruction_candidates unresolved = { .indices = nullptr, .count = 0 };
+
+			// memory operands which reference a symbol can also be matched by an immediate/relocation
+			for(u8 k = 0; k < count; ++k) {
+				if(operands[k].unknown && get_operand_class(operands[k].type) != OC_IMM) {
+					unresolved = get_instruction_candidates(mnemonic, set_signature_class(signature, k, OC_IMM));
+					break;
+				}
+			}
+
+			// walk both candidate lists in database order, the first match wins
+			u16 i = 0;
+			u16 j = 0;
+
+			while(i < candidates.count || j < unresolved.count) {
+				u32 index;
+
+				if(j == unresolved.count || (i < candidates.count && candidates.indices[i] < unresolved.indices[j])) {
+					index = candidates.indices[i++];
+				}
+				else {
+					index = unresolved.indices[j++];
+				}
+
+				// verify that the current instruction matches the provided operands, the operands which
+				// weren't provided have to be implicit
+				const instruction_selection& selection = get_instruction_selection(index);
+
+				if(is_operand_match(selection, operands, broadcast_n, count) && is_implicit_tail(selection, count)) {
+					return index;
+				}
+			}
+
+			return utility::limits<u32>::max();
+		}
+
+		auto get_register_shape(const operand& op) -> u8 {
+			const u8 extension = op.r & 0b00011000; // REX/VEX/EVEX extension bits
+			const u8 low = op.r & 0b00000111;
+
+			switch(get_operand_class(op.type)) {
+				case OC_R8:
+				case OC_R16:
+				case OC_R32:
+				case OC_R64: {
+					// al/ax/eax/rax, cl/ecx/rcx and dx are matched by their index, spl, bpl, sil and dil
+					// need a REX prefix, the remaining registers only differ in their extension bits
+					if(low <= 2) {
+						return extension | low;
+					}
+
+					return extension | (op.type == OP_R8 && low >= spl ? 4 : 3);
+				}
+				case OC_XMM:
+				case OC_YMM:
+				case OC_ZMM:
+				case OC_K: return extension;
+				default:   return op.r;
+			}
+		}
+
+		auto get_instruction_shape(u16 mnemonic, const operand* operands, u8 count, u8 broadcast_n) -> instruction_shape {
+			instruction_shape shape = {};
+
+			for(u8 i = 0; i < count; ++i) {
+				const operand& op = operands[i];
+				u64 word = static_cast<u64>(op.type) | static_cast<u64>(op.unknown) << 8;
+
+				if(is_operand_mem(op.type)) {
+					const mem& memory = op.memory;
+
+					// displacements are either omitted, 8 bits or 32 bits wide
+					const u64 displacement = !memory.has_displacement() ? 0 : memory.displacement.min_bits <= 8 ? 1 : 2;
+
+					word |= static_cast<u64>(memory.has_base) << 9;
+					word |= static_cast<u64>(memory.has_index) << 10;
+					word |= displacement << 11;
+
+					// only the extension bits of the base and index registers influence the encoding, with the
+					// exception of rsp/r12 bases, which need a SIB byte, and rbp/r13 bases, which need a
+					// displacement
+					if(memory.has_base) {
+						const u8 low = memory.base.index & 0b00000111;
+						const u8 base = (memory.base.index & 0b00011000) | (low == 4 || low == 5 ? low : 0);
+						word |= static_cast<u64>(memory.base.type) << 16 | static_cast<u64>(base) << 24;
+					}
+
+					if(memory.has_index) {
+						const u8 index = memory.index.index & 0b00011000;
+						word |= static_cast<u64>(memory.index.type) << 32 | static_cast<u64>(index) << 40;
+					}
+				}
+				else if(is_operand_reg(op.type)) {
+					word |= static_cast<u64>(get_register_shape(op)) << 16;
+				}
+
+				shape.data[i] = word;
+			}
+
+			shape.data[0] |= static_cast<u64>(mnemonic) << 48;
+			shape.data[1] |= static_cast<u64>(broadcast_n) << 48 | static_cast<u64>(count) << 56;
+
+			return shape;
+		}
+
+		auto hash_instruction_shape(const instruction_shape& shape) -> u64 {
+			u64 hash = 0;
+
+			for(const u64 word : shape.data) {
+				hash = (hash ^ word) * 0x9E3779B97F4A7C15;
+				hash ^= hash >> 32;
+			}
+
+			return hash;
+		}
+
+		auto get_chunk_boundary(const utility::string_view& source, u64 position, u64 target) -> u64 {
+			const u64 size = source.get_size();
+
+			// follow the lexer just enough to know whether we're inside of a literal
+			while(position < size) {
+				switch(source[position]) {
+					case '\n': {
+						if(position >= target) {
+							return position + 1; // include the newline
+						}
+
+						position++;
+						break;
+					}
+					case ';': {
+						// comments end at the next newline, which is a valid boundary
+						while(position < size && source[position] != '\n') {
+							position++;
+						}
+
+						break;
+					}
+					case '"': {
+						// string literals can contain newlines and escaped quotes
+						position++;
+
+						while(position < size && source[position] != '"') {
+							position += source[position] == '\\' ? 2 : 1;
+						}
+
+						position++;
+						break;
+					}
+					case '\'': position += 3; break; // char literals hold exactly one (raw) character
+					default:    position++; break;
+				}
+			}
+
+			return size;
+		}
 	} // namespace detail
 
-	frontend::frontend(const utility::dynamic_string& source) : m_module(&m_context) {
-		m_lexer.set_text(source);
-	}
+	frontend::frontend(const utility::dynamic_string& source) : m_module(&m_context), m_source(source.get_data(), source.get_size()) {}
+	frontend::frontend(const utility::string_view& source) : m_module(&m_context), m_source(source) {}
 
 	auto frontend::parse() -> utility::result<module> {
-		TRY(m_lexer.get_next_token()); // prime the first token
+		TRY(parse_source());
+		m_module.commit_instruction_block(BB_INSTRUCTION);
+		TRY(m_module.verify_symbols());
+
+		return m_module;
+	}
+
+	auto frontend::parse_parallel(u64 chunk_count) -> utility::result<module> {
+		if(chunk_count > MAX_CHUNK_COUNT) {
+			chunk_count = MAX_CHUNK_COUNT;
+		}
+
+		if(chunk_count <= 1) {
+			return parse();
+		}
+
+		// split the source into roughly equally sized chunks, every chunk (except for the last one)
+		// ends with a newline, so that no line is shared between two chunks, newlines inside of
+		// literals don't end a line, hence we have to scan the source from the start
+		u64 boundaries[MAX_CHUNK_COUNT + 1];
+		boundaries[0] = 0;
 
-		while(m_lexer.current != TOK_EOF) {
+		for(u64 i = 1; i < chunk_count; ++i) {
+			boundaries[i] = detail::get_chunk_boundary(m_source, boundaries[i - 1], m_source.get_size() * i / chunk_count);
+		}
+
+		boundaries[chunk_count] = m_source.get_size();
+
+		// every chunk is parsed into a separate log, once a chunk is parsed, we wait for the previous
+		// chunk to be replayed, and then replay our own log into the final module, since the chunk
+		// parser owns the symbols referenced by the log it has to stay alive until it's been replayed
+		std::atomic<u64> replay_index = 0;
+		utility::result<void> result = SUCCESS;
+		std::thread workers[MAX_CHUNK_COUNT];
+
+		for(u64 i = 0; i < chunk_count; ++i) {
+			workers[i] = std::thread([&, i] {
+				frontend parser(utility::string_view(m_source.get_data() + boundaries[i], boundaries[i + 1] - boundaries[i]));
+				module_log log;
+
+				parser.m_log = &log;
+				const auto parse_result = parser.parse_source();
+
+				for(u64 current = replay_index.load(); current != i; current = replay_index.load()) {
+					replay_index.wait(current);
+				}
+
+				m_selection_stats.hits += parser.m_selection_stats.hits;
+				m_selection_stats.misses += parser.m_selection_stats.misses;
+
+				// errors from earlier chunks take precedence, since they'd be reported first by a serial
+				// parse as well
+				if(!result.has_error()) {
+					const auto replay_result = log.replay(m_module);
+
+					if(replay_result.has_error()) {
+						result = replay_result;
+					}
+					else if(parse_result.has_error()) {
+						result = parse_result;
+					}
+				}
+
+				replay_index.store(i + 1);
+				replay_index.notify_all();
+			});
+		}
+
+		for(u64 i = 0; i < chunk_count; ++i) {
+			workers[i].join();
+		}
+
+		TRY(result);
+		m_module.commit_instruction_block(BB_INSTRUCTION);
+		TRY(m_module.verify_symbols());
+
+		return m_module;
+	}
+
+	auto frontend::get_selection_cache_stats() const -> selection_cache_stats {
+		return m_selection_stats;
+	}
+
+	auto frontend::parse_source() -> utility::result<void> {
+		if(m_selection_cache.get_size() == 0) {
+			m_selection_cache.resize(SELECTION_CACHE_SIZE);
+
+			for(selection_entry& entry : m_selection_cache) {
+				entry.index = utility::limits<u32>::max();
+			}
+		}
+
+		TRY(m_tokens.tokenize(m_source));
+		m_tokens.get_next_token(); // prime the first token
+
+		while(m_tokens.current != TOK_EOF) {
 			// top-level directives
-			switch(m_lexer.current) {
-				case TOK_NEWLINE:           TRY(m_lexer.get_next_token()); break;
+			switch(m_tokens.current) {
+				case TOK_NEWLINE:           m_tokens.get_next_token(); break;
 				case TOK_RESB ... TOK_RESQ: TRY(parse_reserve_memory()); break;
 				case TOK_DB ... TOK_DQ:     TRY(parse_define_memory()); break; // unnamed memory define
 				case TOK_IDENTIFIER:        TRY(parse_identifier()); break;
@@ -139,19 +403,81 @@ return false;
 				case TOK_GLOBAL:            TRY(parse_global()); break;
 				case TOK_TIMES:             TRY(parse_times()); break;
 				case TOK_BITS:              TRY(parse_bits()); break;
-				default: ASSERT(false, "unexpected top level token: {}\n", token_to_string(m_lexer.current)); 
+				default: ASSERT(false, "unexpected top level token: {}\n", token_to_string(m_tokens.current)); 
 			}	
 		}
 
-		m_module.commit_instruction_block(BB_INSTRUCTION);
+		return SUCCESS;
+	}
 
-		return m_module;
+	void frontend::stage_instruction(const operand* operands, u32 index, u8 size) {
+		if(m_log) {
+			m_log->stage_instruction(operands, index, size);
+		}
+		else {
+			m_module.stage_instruction(operands, index, size);
+		}
+	}
+
+	void frontend::commit_instruction_block(basic_block_type ty) {
+		if(m_log) {
+			m_log->commit_instruction_block(ty);
+		}
+		else {
+			m_module.commit_instruction_block(ty);
+		}
+	}
+
+	void frontend::commit_label_block(utility::string_view* name) {
+		if(m_log) {
+			m_log->commit_label_block(name);
+		}
+		else {
+			m_module.commit_label_block(name);
+		}
+	}
+
+	void frontend::commit_data_block(const utility::dynamic_array<u8>& data) {
+		if(m_log) {
+			m_log->commit_data_block(data);
+		}
+		else {
+			m_module.commit_data_block(data);
+		}
+	}
+
+	auto frontend::declare_symbol(utility::string_view* name) -> utility::result<void> {
+		if(m_log) {
+			// redeclarations are detected once the log is replayed
+			m_log->declare_symbol(name);
+			return SUCCESS;
+		}
+
+		return m_module.declare_symbol(name);
+	}
+
+	void frontend::declare_global(utility::string_view* name) {
+		if(m_log) {
+			m_log->declare_global(name);
+		}
+		else {
+			m_module.declare_global(name);
+		}
+	}
+
+	void frontend::set_section(utility::string_view* name) {
+		if(m_log) {
+			m_log->set_section(name);
+		}
+		else {
+			m_module.set_section(name);
+		}
 	}
 
 	auto frontend::parse_reserve_memory() -> utility::result<void> {
 		u8 bytes = 0;
 
-		switch(m_lexer.current) {
+		switch(m_tokens.current) {
 			case TOK_RESB: bytes = 1; break;
 			case TOK_RESW: bytes = 2; break;
 			case TOK_RESD: bytes = 4; break;
@@ -162,12 +488,12 @@ return false;
 		SUPPRESS_C4100(bytes);
 
 		// ignored for now, this only appears in object formats
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 		EXPECT_TOKEN(TOK_NUMBER);
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 
 		//if(*m_sections[m_section_index].name != ".bss") {
-		//	for(u64 i = 0; i < m_lexer.current_immediate.value; ++i) {
+		//	for(u64 i = 0; i < m_tokens.current_immediate.value; ++i) {
 		//		m_current_resolved.push_back(0);
 		//	}
 		//}
@@ -178,13 +504,13 @@ return false;
 	auto frontend::parse_define_memory(utility::string_view* symbol) -> utility::result<void> {
 		// define mem doesn't have to have a symbol associated with it
 		if(symbol) {
-			TRY(m_module.declare_symbol(symbol));
+			TRY(declare_symbol(symbol));
 		}
 
 		bool sign = false;
 		u8 bytes = 0;
 
-		switch(m_lexer.current) {
+		switch(m_tokens.current) {
 			case TOK_DB: bytes = 1; break;
 			case TOK_DW: bytes = 2; break;
 			case TOK_DD: bytes = 4; break;
@@ -193,19 +519,19 @@ return false;
 		}
 
 		// TODO: check for multiple definitions
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 		utility::dynamic_array<u8> data;
 
-		while(m_lexer.current != TOK_EOF) {
-			switch(m_lexer.current) {
+		while(m_tokens.current != TOK_EOF) {
+			switch(m_tokens.current) {
 				case TOK_CHAR: 
 				case TOK_STRING: {
-					for(const char c : m_lexer.current_string) {
+					for(const char c : m_tokens.current_string) {
 						data.push_back(c);
 					}
 
 					// apend missing bytes, so that we're aligned with our data type
-					const u64 offset = m_lexer.current_string.get_size();
+					const u64 offset = m_tokens.current_string.get_size();
 					const u64 alignment_offset = utility::align(offset, bytes) - offset; 
 
 					for(u64 i = 0; i < alignment_offset; ++i) {
@@ -216,11 +542,11 @@ return false;
 				}
 				case TOK_MINUS: {
 					sign = true; 
-					TRY(m_lexer.get_next_token());
+					m_tokens.get_next_token();
 					EXPECT_TOKEN(TOK_NUMBER);
 				}
 				case TOK_NUMBER: {
-					u64 value = m_lexer.current_immediate.value;
+					u64 value = m_tokens.current_immediate.value;
 
 					if(sign) {
 						value = static_cast<u64>(static_cast<i64>(value) * -1);
@@ -238,40 +564,43 @@ return false;
 				default: return utility::error("unexpected token following memory definition");
 			}
 			
-			TRY(m_lexer.get_next_token());
+			m_tokens.get_next_token();
 
 			// memory define operands should be comma separated
-			if(m_lexer.current != TOK_COMMA) {
+			if(m_tokens.current != TOK_COMMA) {
 				break;
 			}
 		
-			TRY(m_lexer.get_next_token());
+			m_tokens.get_next_token();
 		}
 
-		m_module.commit_data_block(data);
-		TRY(m_lexer.get_next_token());
+		commit_data_block(data);
+		m_tokens.get_next_token();
 
 		return SUCCESS;
 	}
 	
 	auto frontend::parse_instruction(utility::string_view* symbol) -> utility::result<void> {
-		// locate the first instruction with the specified mnemonic
-		const u32 start = m_instruction_i = backend::get_instruction_by_name(symbol->get_data());
+		// locate the mnemonic group, m_instruction_i points to its first instruction while we're parsing
+		// operands (used by broadcasts)
+		const u16 mnemonic = get_mnemonic(*symbol);
 
-		if(m_instruction_i == utility::limits<u32>::max()) {
+		if(mnemonic == INVALID_MNEMONIC) {
 			ASSERT(false, "unknown instruction '{}' specified\n", *symbol);
+			return utility::error("unknown instruction specified");
 		}
 
+		const u32 start = m_instruction_i = get_mnemonic_info(mnemonic).first;
+
 		// ensure our destination is clean
 		utility::memset(m_operands, 0, sizeof(operand) * 4);
 
-		m_unresolved_index = utility::limits<u8>::max();
 		m_broadcast_n = 0;
 		m_operand_i = 0;
 
 		// parse instruction operands
-		while(m_lexer.current != TOK_EOF && m_lexer.current != TOK_NEWLINE) {
-			switch(m_lexer.current) {
+		while(m_tokens.current != TOK_EOF && m_tokens.current != TOK_NEWLINE) {
+			switch(m_tokens.current) {
 				case TOK_LBRACKET:           TRY(parse_memory_operand(DT_NONE)); break; 
 				case TOK_IDENTIFIER:         TRY(parse_identifier_operand()); break;
 				case TOK_MINUS:              TRY(parse_immediate_operand()); break;
@@ -280,32 +609,40 @@ return false;
 				case TOK_DOLLARSIGN:         TRY(parse_rip_rel_operand()); break;
 				case TOK_BYTE ... TOK_TWORD: TRY(parse_type_operand()); break;
 				case TOK_CHAR:               TRY(parse_operand_char()); break;
-				default: ASSERT(false, "unexpected operand token: {}\n", token_to_string(m_lexer.current)); 
+				default: ASSERT(false, "unexpected operand token: {}\n", token_to_string(m_tokens.current)); 
 			}
 
-			if(m_lexer.current != TOK_COMMA) {
+			if(m_tokens.current != TOK_COMMA) {
 				break;
 			}
 
-			TRY(m_lexer.get_next_token());
+			m_tokens.get_next_token();
 		}
 
-		// locate the specific variant (dumb linear search in our specific mnemonic group)
-		while(m_instruction_i < INSTRUCTION_DB_SIZE) {
-			const instruction& current = INSTRUCTION_DB[m_instruction_i]; 
+		// instructions with the same shape always result in the same selected instruction with the
+		// same size, check if we've seen this one before
+		const detail::instruction_shape shape = detail::get_instruction_shape(mnemonic, m_operands, m_operand_i, m_broadcast_n);
+		selection_entry& entry = m_selection_cache[detail::hash_instruction_shape(shape) & (SELECTION_CACHE_SIZE - 1)];
 
-			// verify that the instruction names are the same and that we've not left our instruction group
-			if(*symbol != current.name) {
-				break;
-			}
+		if(entry.index != utility::limits<u32>::max() && entry.shape == shape) {
+			ASSERT(select_instruction(mnemonic) == entry.index, "selection cache mismatch\n");
+			m_selection_stats.hits++;
 
-			// verify that the current instruction matches the provided operands
-			if(detail::is_operand_match(current, m_operands, m_broadcast_n, m_operand_i)) {
-				assemble_instruction(&current); // matching instruction found, stage it
-				return SUCCESS;
-			}
+			m_instruction_i = entry.index;
+			assemble_instruction(&INSTRUCTION_DB[entry.index], entry.size);
+			return SUCCESS;
+		}
+
+		m_selection_stats.misses++;
+		const u32 index = select_instruction(mnemonic);
 
-			m_instruction_i++;
+		if(index != utility::limits<u32>::max()) {
+			m_instruction_i = index;
+
+			entry.shape = shape;
+			entry.index = index;
+			entry.size = assemble_instruction(&INSTRUCTION_DB[index]); // matching instruction found, stage it
+			return SUCCESS;
 		}
 
 		utility::console::print_err("'{}': ", INSTRUCTION_DB[start].name);
@@ -318,25 +655,39 @@ return false;
 		return utility::error("invalid operand combination for the specified instruction");
 	}
 
-	void frontend::assemble_instruction(const instruction* inst) {
+	auto frontend::select_instruction(u16 mnemonic) -> u32 {
+		return detail::select_instruction(mnemonic, m_operands, m_operand_i, m_broadcast_n);
+	}
+
+	auto frontend::assemble_instruction(const instruction* inst, u8 size) -> u8 {
 		// operands match, but, in some cases we need to retype some of them to the actual type, ie. 
-		// immediates can actually be relocations
+		// immediates can actually be relocations, symbolic operands are retyped once they're resolved,
+		// unless they're memory operands, whose type doesn't depend on the symbol
 		for(u8 i = 0; i < m_operand_i; ++i) {
-			if(i == m_unresolved_index) {
+			if(m_operands[i].unknown && !is_operand_mem(inst->operands[i])) {
 				continue;
 			}
 
 			m_operands[i].type = inst->operands[i];
 		}
 
-		// assemble the instruction and use that as the size 
-		const auto code = backend::emit_instruction(m_instruction_i, m_operands);
-		m_module.stage_instruction(m_operands, m_instruction_i, code.size);
+		// calculate the size of the instruction, unless we already know it
+		if(size == 0) {
+			size = backend::compute_size(m_instruction_i, m_operands);
+		}
+
+#ifdef DEBUG
+		u8 encoded[MAX_INSTRUCTION_SIZE];
+		ASSERT(size == backend::emit_instruction(m_instruction_i, m_operands, encoded), "instruction size mismatch\n");
+#endif
+		stage_instruction(m_operands, m_instruction_i, size);
 
 		// force a branch block
 		if(is_jump_or_branch_inst(m_instruction_i)) {
-			m_module.commit_instruction_block(BB_BRANCH);
+			commit_instruction_block(BB_BRANCH);
 		}
+
+		return size;
 	}
 
 	auto frontend::parse_moff_operand(data_type type) -> utility::result<void> {
@@ -344,50 +695,44 @@ return false;
 			return utility::error("duplicate data type specified in memory/moff operand");
 		}
 
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 		EXPECT_TOKEN(TOK_NUMBER);
 
-		m_operands[m_operand_i++] = operand(moff(m_lexer.current_immediate.value));
+		m_operands[m_operand_i++] = operand(moff(m_tokens.current_immediate.value));
 
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 		EXPECT_TOKEN(TOK_RBRACKET);
 
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 		return SUCCESS;
 	}
 
 	auto frontend::parse_broadcast_operand(mask_type mask) -> utility::result<void> {
 		m_broadcast_n = mask_to_broadcast_n(mask);
 		
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 		EXPECT_TOKEN(TOK_RBRACE);
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 
-		u32 index = m_instruction_i;
+		const mnemonic& info = get_mnemonic_info(INSTRUCTION_DB[m_instruction_i].mnemonic);
+		const u32 end = info.first + info.count;
 		bool met_broadcast = false;
 
 		// find the bn from the current instruction
-		while(index < INSTRUCTION_DB_SIZE) {
-			const instruction& current = INSTRUCTION_DB[index];
-
-			if(utility::compare_strings(INSTRUCTION_DB[m_instruction_i].name, current.name) != 0) {
-				break;
-			}
+		for(u32 index = m_instruction_i; index < end; ++index) {
+			const instruction_selection& current = get_instruction_selection(index);
 
 			if(detail::is_operand_match(current, m_operands, m_broadcast_n, m_operand_i)) {
-				operand_type ty = current.operands[current.get_broadcast_operand()];
 				met_broadcast = true;
 
-				if(broadcast_to_bits(ty) * m_broadcast_n == inst_size_to_int(current.op_size)) {
+				if(current.broadcast_n == m_broadcast_n) {
 					operand op;
-					op.type = ty;
+					op.type = INSTRUCTION_DB[index].operands[INSTRUCTION_DB[index].get_broadcast_operand()];
 					m_operands[m_operand_i++] = op;
 
 					return SUCCESS;
 				}
 			}
-
-			index++;
 		}
 
 		if(met_broadcast) {
@@ -410,10 +755,10 @@ return false;
 			case DT_NONE:  op.type = OP_M128; break; // M128 currently works as an infer keyword
 		}
 	
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 
 		// we can potentially have types in here, which means we're handling a moff
-		switch(m_lexer.current) {
+		switch(m_tokens.current) {
 			case TOK_BYTE ... TOK_TWORD: return parse_moff_operand(type);
 			default: break;
 		}
@@ -449,34 +794,32 @@ return false;
 	}
 
 	auto frontend::parse_identifier_operand() -> utility::result<void> {
-		// TODO: add support for multiple symbolic operands per instruction
-		m_unresolved_index = m_operand_i;
-		m_operands[m_operand_i++] = operand(m_context.strings.add(m_lexer.current_string)); 
-		TRY(m_lexer.get_next_token());
+		m_operands[m_operand_i++] = operand(m_context.strings.add(m_tokens.current_string)); 
+		m_tokens.get_next_token();
 
 		return SUCCESS;
 	}
 
 	auto frontend::parse_immediate_operand() -> utility::result<void> {
-		if(m_lexer.current == TOK_MINUS) {
-			TRY(m_lexer.get_next_token());
+		if(m_tokens.current == TOK_MINUS) {
+			m_tokens.get_next_token();
 			EXPECT_TOKEN(TOK_NUMBER);
 
-			m_operands[m_operand_i++] = operand(imm(-static_cast<i64>(m_lexer.current_immediate.value))); 
+			m_operands[m_operand_i++] = operand(imm(-static_cast<i64>(m_tokens.current_immediate.value))); 
 		}
 		else {
 			EXPECT_TOKEN(TOK_NUMBER);
 
-			m_operands[m_operand_i++] = operand(m_lexer.current_immediate); 
+			m_operands[m_operand_i++] = operand(m_tokens.current_immediate); 
 		}
 
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 
 		return SUCCESS;
 	}
 
 	auto frontend::parse_register_operand() -> utility::result<void> {
-		operand op = operand(token_to_register(m_lexer.current));
+		operand op = operand(token_to_register(m_tokens.current));
 		TRY(mask_type mask, parse_mask_or_broadcast());
 
 		if(mask == MASK_NONE) {
@@ -499,11 +842,11 @@ return false;
 
 	auto frontend::parse_type_operand() -> utility::result<void> {
 		// parse an operand which begins with a type keyword 
-		data_type type = token_to_data_type(m_lexer.current);
+		data_type type = token_to_data_type(m_tokens.current);
 
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 
-		switch(m_lexer.current) {
+		switch(m_tokens.current) {
 			case TOK_LBRACKET: TRY(parse_memory_operand(type)); break;
 			default: return utility::error("unexpected token following type");
 		}
@@ -513,60 +856,60 @@ return false;
 
 	auto frontend::parse_operand_char() -> utility::result<void> {
 		EXPECT_TOKEN(TOK_CHAR);
-		m_operands[m_operand_i++] = imm(static_cast<i32>(m_lexer.current_string[0]));
-		TRY(m_lexer.get_next_token());
+		m_operands[m_operand_i++] = imm(static_cast<i32>(m_tokens.current_string[0]));
+		m_tokens.get_next_token();
 
 		return SUCCESS;
 	}
 
 	auto frontend::parse_rip_rel_operand() -> utility::result<void> {
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 
-		if(m_lexer.current != TOK_PLUS) {
+		if(m_tokens.current != TOK_PLUS) {
 			return utility::error("unexpected token received in rip-relative address");
 		}
 
 		operand rip_rel; 
 
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 
-		if(m_lexer.current == TOK_MINUS) {
+		if(m_tokens.current == TOK_MINUS) {
 			// negative relocations are always rel32 (without being rip-relative)
 			rip_rel.type = OP_REL32;
 
-			TRY(m_lexer.get_next_token());
+			m_tokens.get_next_token();
 			EXPECT_TOKEN(TOK_NUMBER);
 
 			// HACK: all instructions which use a negative rip-relative operand are 4 bytes long, we can
 			//       just subtract that and treat these instructions as their rel32 variants
-			rip_rel.immediate = imm(-1 * static_cast<i64>(m_lexer.current_immediate.value - 4));
+			rip_rel.immediate = imm(-1 * static_cast<i64>(m_tokens.current_immediate.value - 4));
 		} 
 		else {
 			EXPECT_TOKEN(TOK_NUMBER);
 
 			// select the actual data type
-			switch(m_lexer.current_immediate.min_bits) {
+			switch(m_tokens.current_immediate.min_bits) {
 				case 8:  rip_rel.type = OP_REL8_RIP;  break;
 				case 16: rip_rel.type = OP_REL16_RIP; break;
 				case 32: rip_rel.type = OP_REL32_RIP; break;
 				default: return utility::error("invalid rip-relative address width");
 			}
 
-			rip_rel.immediate = m_lexer.current_immediate;
+			rip_rel.immediate = m_tokens.current_immediate;
 		}
 
 		m_operands[m_operand_i++] = rip_rel;
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 
 		return SUCCESS;
 	}
 
 	auto frontend::parse_identifier() -> utility::result<void> {
 		EXPECT_TOKEN(TOK_IDENTIFIER);
-		utility::string_view* identifier = m_context.strings.add(m_lexer.current_string);
-		TRY(m_lexer.get_next_token());
+		utility::string_view* identifier = m_context.strings.add(m_tokens.current_string);
+		m_tokens.get_next_token();
 
-		switch(m_lexer.current) {
+		switch(m_tokens.current) {
 			case TOK_DB ... TOK_DQ: return parse_define_memory(identifier);
 			case TOK_COLON:         return parse_label(identifier);
 			default:                return parse_instruction(identifier);
@@ -578,62 +921,61 @@ return false;
 	auto frontend::parse_section() -> utility::result<void> {
 		EXPECT_TOKEN(TOK_SECTION);
 
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 		EXPECT_TOKEN(TOK_IDENTIFIER);
-		ASSERT(m_lexer.current_string[0] == '.', "first char of a section should be a '.'\n");
+		ASSERT(m_tokens.current_string[0] == '.', "first char of a section should be a '.'\n");
 
-		m_module.set_section(m_context.strings.add(m_lexer.current_string));
+		set_section(m_context.strings.add(m_tokens.current_string));
 
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 		return SUCCESS;
 	}
 
 	auto frontend::parse_global() -> utility::result<void> {
 		EXPECT_TOKEN(TOK_GLOBAL);
 
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 		EXPECT_TOKEN(TOK_IDENTIFIER);
 
-		// utility::console::print("global symbol: '{}'\n", m_lexer.current_string);
-		// m_module.add_symbol(m_context.strings.add(m_lexer.current_string), SYM_GLOBAL);
+		declare_global(m_context.strings.add(m_tokens.current_string));
 
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 		return SUCCESS;
 	}
 
 	auto frontend::parse_label(utility::string_view* symbol) -> utility::result<void> {
 		EXPECT_TOKEN(TOK_COLON);
 
-		TRY(m_module.declare_symbol(symbol));
-		TRY(m_lexer.get_next_token());
+		TRY(declare_symbol(symbol));
+		m_tokens.get_next_token();
 
-		m_module.commit_label_block(symbol);
+		commit_label_block(symbol);
 		
 		return SUCCESS;
 	}
 	
 	auto frontend::parse_times() -> utility::result<void> {
 		EXPECT_TOKEN(TOK_TIMES);
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 		EXPECT_TOKEN(TOK_NUMBER);
 
-		const u64 times = m_lexer.current_immediate.value;
-		const auto safepoint = m_lexer.create_safepoint();
+		const u64 times = m_tokens.current_immediate.value;
+		const auto safepoint = m_tokens.create_safepoint();
 
 		// revisit the current line 'times' times
 		for(u64 i = 0; i < times; ++i) {
-			m_lexer.restore_safepoint(safepoint);
-			TRY(m_lexer.get_next_token()); // prime the first token
+			m_tokens.restore_safepoint(safepoint);
+			m_tokens.get_next_token(); // prime the first token
 
-			switch(m_lexer.current) {
+			switch(m_tokens.current) {
 				case TOK_RESB ... TOK_RESQ: TRY(parse_reserve_memory()); break;
 				case TOK_DB ... TOK_DQ:     TRY(parse_define_memory()); break; // unnamed memory define
 				case TOK_IDENTIFIER:        TRY(parse_identifier()); break;
-				default: ASSERT(false, "unexpected times token: {}\n", token_to_string(m_lexer.current)); 
+				default: ASSERT(false, "unexpected times token: {}\n", token_to_string(m_tokens.current)); 
 			}
 		}
 
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 
 		return SUCCESS;
 	}
@@ -641,9 +983,9 @@ return false;
 	auto frontend::parse_bits() -> utility::result<void> {
 		// TODO: currently unused, used for the sake of test compatibility
 		EXPECT_TOKEN(TOK_BITS);
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 		EXPECT_TOKEN(TOK_NUMBER);
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 
 		return SUCCESS;
 	}
@@ -662,7 +1004,7 @@ return false;
 		
 		// entry
 		while(true) {
-			switch(m_lexer.current) {
+			switch(m_tokens.current) {
 				// register
 				case TOK_CR0 ... TOK_R15B: {
 					if(scale_mode && imm_set) {
@@ -671,7 +1013,7 @@ return false;
 							return utility::error("memory index cannot be specified twice");
 						}
 
-						memory.index = token_to_register(m_lexer.current);
+						memory.index = token_to_register(m_tokens.current);
 						memory.has_index = true;
 
 						TRY(memory.s, detail::imm_to_scale(current_imm));
@@ -680,14 +1022,14 @@ return false;
 						imm_set = false;
 					}
 					else {
-						current_reg = token_to_register(m_lexer.current);
+						current_reg = token_to_register(m_tokens.current);
 					}
 
 					break;
 				}
 				// rel $
 				case TOK_REL: {
-					TRY(m_lexer.get_next_token());
+					m_tokens.get_next_token();
 					EXPECT_TOKEN(TOK_DOLLARSIGN);
 					current_reg = rip;
 
@@ -733,7 +1075,7 @@ return false;
 				}
 				case TOK_MINUS: {
 					negate = true;
-					TRY(m_lexer.get_next_token());
+					m_tokens.get_next_token();
 					EXPECT_TOKEN(TOK_NUMBER);
 					[[fallthrough]];
 				}
@@ -751,7 +1093,7 @@ return false;
 						memory.index = current_reg;
 						memory.has_index = true;
 
-						TRY(memory.s, detail::imm_to_scale(m_lexer.current_immediate));
+						TRY(memory.s, detail::imm_to_scale(m_tokens.current_immediate));
 
 						scale_mode = false;
 						current_reg = reg::create_invalid();
@@ -759,10 +1101,10 @@ return false;
 					else{
 						// immediate
 						if(negate) {
-							current_imm = imm(-1 * static_cast<i64>(m_lexer.current_immediate.value));
+							current_imm = imm(-1 * static_cast<i64>(m_tokens.current_immediate.value));
 						}
 						else {
-							current_imm = m_lexer.current_immediate;
+							current_imm = m_tokens.current_immediate;
 						}
 
 						imm_set = true;
@@ -828,8 +1170,7 @@ return false;
 					return SUCCESS;
 				}
 				case TOK_IDENTIFIER: {
-					m_unresolved_index = m_operand_i;
-					op.symbol = m_context.strings.add(m_lexer.current_string);
+					op.symbol = m_context.strings.add(m_tokens.current_string);
 					op.unknown = true;
 					memory.displacement.min_bits = 32;
 					displacement_set = true;
@@ -841,23 +1182,23 @@ return false;
 				}
 			}
 
-			TRY(m_lexer.get_next_token());
+			m_tokens.get_next_token();
 		}
 	}
 
 	auto frontend::parse_mask_or_broadcast() -> utility::result<mask_type> {
 		mask_type result = MASK_NONE;
 
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 
-		if(m_lexer.current != TOK_LBRACE) {
+		if(m_tokens.current != TOK_LBRACE) {
 			return result; // no mask
 		}
 
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 
 		// broadcast
-		switch(m_lexer.current) {
+		switch(m_tokens.current) {
 			case TOK_1TO2:  return MASK_BROADCAST_1TO2;
 			case TOK_1TO4:  return MASK_BROADCAST_1TO4;
 			case TOK_1TO8:  return MASK_BROADCAST_1TO8;
@@ -869,7 +1210,7 @@ return false;
 		u8 k = 0;
 
 		// k
-		switch(m_lexer.current) {
+		switch(m_tokens.current) {
 			case TOK_K1: k = 1; break;
 			case TOK_K2: k = 2; break;
 			case TOK_K3: k = 3; break;
@@ -882,23 +1223,23 @@ return false;
 
 		result = static_cast<mask_type>(k + 1);
 
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 		EXPECT_TOKEN(TOK_RBRACE);
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 
-		if(m_lexer.current != TOK_LBRACE) {
+		if(m_tokens.current != TOK_LBRACE) {
 			return result; // no zero mask
 		}
 
 		// parse the second mask operand '{z}'
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 		EXPECT_TOKEN(TOK_Z);
 
 		result = static_cast<mask_type>(result + 8);
 
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 		EXPECT_TOKEN(TOK_RBRACE);
-		TRY(m_lexer.get_next_token());
+		m_tokens.get_next_token();
 
 		return result;
 	}
@@ -1,7 +1,8 @@
 #pragma once
 #include "assembler/instruction/instruction.h"
+#include "assembler/ir/module_log.h"
 #include "assembler/ir/module.h"
-#include "assembler/lexer.h"
+#include "assembler/token_stream.h"
 
 namespace baremetal::assembler {
 	namespace detail {
@@ -9,15 +10,56 @@ namespace baremetal::assembler {
 		[[nodiscard]] auto imm_to_scale(const imm& i) -> utility::result<scale>;
 
 		[[nodiscard]] auto is_operand_match(operand_type a, operand b) -> bool;
-		[[nodiscard]] auto is_operand_match(const instruction& inst, operand* operands, u8 broadcast_n, u8 count) -> bool;
+		[[nodiscard]] auto is_operand_match(const instruction_selection& inst, const operand* operands, u8 broadcast_n, u8 count) -> bool;
+
+		// locates the first variant of the mnemonic which matches the operands, returns
+		// utility::limits<u32>::max() if there is none
+		[[nodiscard]] auto select_instruction(u16 mnemonic, const operand* operands, u8 count, u8 broadcast_n) -> u32;
+
+		// shape of an instruction, contains everything which influences instruction selection and the
+		// size of the encoded instruction (mnemonic, operand types, registers, memory operand forms and
+		// displacement widths, broadcasts), but not the values of immediates and displacements
+		struct instruction_shape {
+			[[nodiscard]] auto operator==(const instruction_shape& other) const -> bool = default;
+
+			u64 data[4]; // one word per operand, the mnemonic and operand count live in the upper bits
+		};
+
+		[[nodiscard]] auto get_register_shape(const operand& op) -> u8;
+		[[nodiscard]] auto get_instruction_shape(u16 mnemonic, const operand* operands, u8 count, u8 broadcast_n) -> instruction_shape;
+		[[nodiscard]] auto hash_instruction_shape(const instruction_shape& shape) -> u64;
+
+		// returns the position past the first newline at or after 'target' which ends a line, newlines
+		// in string literals, char literals and comments don't count, 'position' has to be the start
+		// of a line
+		[[nodiscard]] auto get_chunk_boundary(const utility::string_view& source, u64 position, u64 target) -> u64;
 	} // namespace detail
 
+	struct selection_cache_stats {
+		u64 hits;
+		u64 misses;
+	};
+
 	class frontend {
 	public:
+		// the source text isn't copied, it has to outlive the frontend
 		frontend(const utility::dynamic_string& source);
+		frontend(const utility::string_view& source);
 
 		[[nodiscard]] auto parse() -> utility::result<module>;
+
+		// splits the source into 'chunk_count' chunks at line boundaries and parses them in parallel,
+		// produces the same module as parse()
+		[[nodiscard]] auto parse_parallel(u64 chunk_count) -> utility::result<module>;
+
+		// lookups into the instruction selection cache, accumulated over every parse
+		[[nodiscard]] auto get_selection_cache_stats() const -> selection_cache_stats;
+
+		static constexpr u64 MAX_CHUNK_COUNT = 64;
+		static constexpr u64 SELECTION_CACHE_SIZE = 4096; // power of two
 	private:
+		[[nodiscard]] auto parse_source() -> utility::result<void>;
+
 		// parsing
 		[[nodiscard]] auto parse_define_memory(utility::string_view* symbol = nullptr) -> utility::result<void>;
 		[[nodiscard]] auto parse_instruction(utility::string_view* symbol) -> utility::result<void>;
@@ -43,18 +85,48 @@ namespace baremetal::assembler {
 		[[nodiscard]] auto parse_mask_or_broadcast() -> utility::result<mask_type>; 
 		[[nodiscard]] auto parse_memory(operand& op) -> utility::result<void>;
 
-		void assemble_instruction(const instruction* inst);
+		// locates the first variant of the mnemonic which matches the parsed operands, returns
+		// utility::limits<u32>::max() if there is none
+		[[nodiscard]] auto select_instruction(u16 mnemonic) -> u32;
+
+		// stages the instruction, if the size is 0 it is calculated from the operands first, returns
+		// the size of the instruction
+		auto assemble_instruction(const instruction* inst, u8 size = 0) -> u8;
+
+		// module construction, applied to the module directly, or recorded into the log when we're
+		// parsing a chunk of a larger source
+		void stage_instruction(const operand* operands, u32 index, u8 size);
+		void commit_instruction_block(basic_block_type ty);
+		void commit_label_block(utility::string_view* name);
+		void commit_data_block(const utility::dynamic_array<u8>& data);
+		void set_section(utility::string_view* name);
+
+		[[nodiscard]] auto declare_symbol(utility::string_view* name) -> utility::result<void>;
+		void declare_global(utility::string_view* name);
 	private:
 		context m_context;
 		module m_module;
-		lexer m_lexer;
+		module_log* m_log = nullptr;
+
+		utility::string_view m_source;
+		token_stream m_tokens;
 
 		// instruction parsing
 		u32 m_instruction_i;
 		operand m_operands[4];
 		u8 m_broadcast_n;
 		u8 m_operand_i;
-		u8 m_unresolved_index;
+
+		// instruction selection cache, maps instruction shapes to the selected instruction and its
+		// size, so that repeated shapes don't have to go through selection and encoding again
+		struct selection_entry {
+			detail::instruction_shape shape;
+			u32 index; // INSTRUCTION_DB index, utility::limits<u32>::max() for empty entries
+			u8 size;
+		};
+
+		utility::dynamic_array<selection_entry> m_selection_cache;
+		selection_cache_stats m_selection_stats = {};
 	};
 } // namespace baremetal::assembler
 
@@ -105,58 +105,74 @@ namespace baremetal::assembler {
 		ENC_XOP,
 	};
 
+	[[nodiscard]] constexpr auto is_rex_encoding(encoding enc) -> bool {
+		switch(enc) { 
+			case ENC_NORMAL:
+			case ENC_NORMALD:
+			case ENC_MR:
+			case ENC_M:
+			case ENC_RM:
+			case ENC_RMR:
+			case ENC_R: return true;
+			default:    return false;
+		}
+	}
+
+	[[nodiscard]] constexpr auto is_vex_xop_encoding(encoding enc) -> bool {
+		switch(enc) {
+			case ENC_XOP:
+			case ENC_XOP_VM:
+			case ENC_VEX:
+			case ENC_VEX_R:
+			case ENC_VEX_MR:
+			case ENC_VEX_RM:
+			case ENC_VEX_RVM:
+			case ENC_VEX_RVMN:
+			case ENC_VEX_RVMS:
+			case ENC_VEX_RMV:
+			case ENC_VEX_MVR:
+			case ENC_VEX_MVRR:
+			case ENC_VEX_VM: return true;
+			default:         return false;
+		}
+	}
+
+	[[nodiscard]] constexpr auto is_xop_encoding(encoding enc) -> bool {
+		switch(enc) {
+			case ENC_XOP:
+			case ENC_XOP_VM: return true;
+			default:         return false;
+		}
+	}
+
+	[[nodiscard]] constexpr auto is_evex_encoding(encoding enc) -> bool {
+		switch(enc) {
+			case ENC_EVEX_RVM:
+			case ENC_EVEX_MVR:
+			case ENC_EVEX_RM:
+			case ENC_EVEX_MR:
+			case ENC_EVEX_VM:
+			case ENC_EVEX_RMZ:
+			case ENC_EVEX_M: return true;
+			default:         return false;
+		}
+	}
+
 	struct instruction { 
 		[[nodiscard]] constexpr auto is_rex() const -> bool {
-			switch(enc) { 
-				case ENC_NORMAL:
-				case ENC_NORMALD:
-				case ENC_MR:
-				case ENC_M:
-				case ENC_RM:
-				case ENC_RMR:
-				case ENC_R: return true;
-				default:    return false;
-			}
+			return is_rex_encoding(enc);
 		}
 
 		[[nodiscard]] constexpr auto is_vex_xop() const -> bool {
-			switch(enc) {
-				case ENC_XOP:
-				case ENC_XOP_VM:
-				case ENC_VEX:
-				case ENC_VEX_R:
-				case ENC_VEX_MR:
-				case ENC_VEX_RM:
-				case ENC_VEX_RVM:
-				case ENC_VEX_RVMN:
-				case ENC_VEX_RVMS:
-				case ENC_VEX_RMV:
-				case ENC_VEX_MVR:
-				case ENC_VEX_MVRR:
-				case ENC_VEX_VM: return true;
-				default:         return false;
-			}
+			return is_vex_xop_encoding(enc);
 		}
 
 		[[nodiscard]] constexpr auto is_xop() const -> bool {
-			switch(enc) {
-				case ENC_XOP:
-				case ENC_XOP_VM: return true;
-				default:         return false;
-			}
+			return is_xop_encoding(enc);
 		}
 
 		[[nodiscard]] constexpr auto is_evex() const -> bool {
-			switch(enc) {
-				case ENC_EVEX_RVM:
-				case ENC_EVEX_MVR:
-				case ENC_EVEX_MR:
-				case ENC_EVEX_VM:
-				case ENC_EVEX_RMZ:
-				case ENC_EVEX_M:
-				case ENC_EVEX_RM: return true;
-				default:          return false;
-			}
+			return is_evex_encoding(enc);
 		}
 
 		[[nodiscard]] constexpr auto is_rexw() const -> bool {
@@ -320,6 +336,7 @@ namespace baremetal::assembler {
 		}
 
 		const char* name;         // instruction mnemonic
+		u16 mnemonic;             // mnemonic ID, shared by all variants of the mnemonic (see MNEMONIC_DB)
 		encoding enc;             // instruction encoding
 		u8 prefix;                // instruction prefix encoded in binary (see prefix)
 		u32 opcode;               // opcode, including the opcode prefix
@@ -332,6 +349,7 @@ namespace baremetal::assembler {
 
 	[[nodiscard]] constexpr auto inst(
 		const char* name, 
+		u16 mnemonic,
 		encoding enc,
 		u8 prefix,
 		u32 opcode,
@@ -346,6 +364,7 @@ namespace baremetal::assembler {
 		instruction result; 
 
 		result.name = name;
+		result.mnemonic = mnemonic;
 		result.enc = enc;
 		result.prefix = prefix;
 		result.opcode = opcode;
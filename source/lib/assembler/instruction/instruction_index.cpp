@@ -0,0 +1,167 @@
+#include "instruction_index.h"
+
+namespace baremetal::assembler {
+	namespace detail {
+		constexpr u32 MNEMONIC_TABLE_SIZE = 4096; // power of two, has to match tools/scripts/tablegen.js
+		constexpr u32 EMPTY_SIGNATURE = utility::limits<u32>::max();
+
+		// MNEMONIC_DB, MNEMONIC_TABLE, SIGNATURE_TABLE, CANDIDATE_DB, VARIANT_TABLE, VARIANT_DB and
+		// SELECTION_DB
+		#include "assembler/instruction/databases/index.inc"
+
+		static_assert(sizeof(MNEMONIC_TABLE) / sizeof(u16) == MNEMONIC_TABLE_SIZE, "mnemonic table size mismatch");
+		static_assert(sizeof(CANDIDATE_DB) / sizeof(u16) <= utility::limits<u16>::max(), "magic number limit reached");
+		static_assert(sizeof(MNEMONIC_DB) / sizeof(mnemonic) < INVALID_MNEMONIC, "magic number limit reached");
+		static_assert(sizeof(VARIANT_TABLE) / sizeof(variant_range) == INSTRUCTION_DB_SIZE * 4, "variant table size mismatch");
+		static_assert(sizeof(VARIANT_DB) / sizeof(u16) <= utility::limits<u16>::max(), "magic number limit reached");
+
+		// every variant has to carry the ID of the mnemonic group it belongs to
+		[[nodiscard]] constexpr auto has_consistent_mnemonic_ids() -> bool {
+			for(u16 id = 0; id < sizeof(MNEMONIC_DB) / sizeof(mnemonic); ++id) {
+				for(u32 i = MNEMONIC_DB[id].first; i < static_cast<u32>(MNEMONIC_DB[id].first + MNEMONIC_DB[id].count); ++i) {
+					if(INSTRUCTION_DB[i].mnemonic != id) {
+						return false;
+					}
+				}
+			}
+
+			return true;
+		}
+
+		static_assert(has_consistent_mnemonic_ids(), "mnemonic IDs don't match the mnemonic table");
+
+		[[nodiscard]] constexpr auto get_broadcast_n(const instruction& inst) -> u8 {
+			u16 size = 0;
+
+			switch(inst.op_size) {
+				case OPS_32:  size = 32;  break;
+				case OPS_64:  size = 64;  break;
+				case OPS_128: size = 128; break;
+				case OPS_256: size = 256; break;
+				case OPS_512: size = 512; break;
+			}
+
+			for(const operand_type op : inst.operands) {
+				switch(op) {
+					case OP_B16: return static_cast<u8>(size / 16);
+					case OP_B32: return static_cast<u8>(size / 32);
+					case OP_B64: return static_cast<u8>(size / 64);
+					default:     break;
+				}
+			}
+
+			return 0;
+		}
+
+		// the selection table has to mirror the instruction database
+		[[nodiscard]] constexpr auto has_consistent_selection_db() -> bool {
+			if(sizeof(SELECTION_DB) / sizeof(instruction_selection) != INSTRUCTION_DB_SIZE) {
+				return false;
+			}
+
+			for(u32 i = 0; i < INSTRUCTION_DB_SIZE; ++i) {
+				const instruction& inst = INSTRUCTION_DB[i];
+				const instruction_selection& selection = SELECTION_DB[i];
+
+				for(u8 j = 0; j < 4; ++j) {
+					if(inst.operands[j] != selection.operands[j]) {
+						return false;
+					}
+				}
+
+				if(selection.evex != inst.is_evex() || selection.broadcast_n != get_broadcast_n(inst)) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		static_assert(has_consistent_selection_db(), "selection table doesn't match the instruction database");
+
+		// has to match hash_mnemonic in tools/scripts/tablegen.js (32 bit FNV-1a)
+		[[nodiscard]] constexpr auto hash_mnemonic(const char* name, u64 size) -> u32 {
+			u32 hash = 2166136261u;
+
+			for(u64 i = 0; i < size; ++i) {
+				hash ^= static_cast<u8>(name[i]);
+				hash *= 16777619u;
+			}
+
+			return hash;
+		}
+
+		// has to match hash_signature in tools/scripts/tablegen.js
+		[[nodiscard]] constexpr auto hash_signature(u32 signature) -> u32 {
+			return (signature * 0x9E3779B1u) >> 16;
+		}
+
+		[[nodiscard]] inline auto is_mnemonic_name(const char* mnemonic, const char* name, u64 size) -> bool {
+			for(u64 i = 0; i < size; ++i) {
+				if(mnemonic[i] != name[i]) {
+					return false;
+				}
+			}
+
+			return mnemonic[size] == '\0';
+		}
+	} // namespace detail
+
+	auto get_mnemonic(const char* name, u64 size) -> u16 {
+		u32 slot = detail::hash_mnemonic(name, size) & (detail::MNEMONIC_TABLE_SIZE - 1);
+
+		// the table is never full, so we'll always hit an empty slot eventually
+		while(detail::MNEMONIC_TABLE[slot] != INVALID_MNEMONIC) {
+			const u16 id = detail::MNEMONIC_TABLE[slot];
+
+			if(detail::is_mnemonic_name(INSTRUCTION_DB[detail::MNEMONIC_DB[id].first].name, name, size)) {
+				return id;
+			}
+
+			slot = (slot + 1) & (detail::MNEMONIC_TABLE_SIZE - 1);
+		}
+
+		return INVALID_MNEMONIC;
+	}
+
+	auto get_mnemonic(const utility::string_view& name) -> u16 {
+		return get_mnemonic(name.get_data(), name.get_size());
+	}
+
+	auto get_mnemonic_info(u16 id) -> const mnemonic& {
+		ASSERT(id != INVALID_MNEMONIC, "invalid mnemonic\n");
+		return detail::MNEMONIC_DB[id];
+	}
+
+	auto get_instruction_candidates(u16 id, u32 signature) -> instruction_candidates {
+		const mnemonic& info = get_mnemonic_info(id);
+		u32 slot = detail::hash_signature(signature) & info.mask;
+
+		while(true) {
+			const struct signature& entry = detail::SIGNATURE_TABLE[info.signatures + slot];
+
+			if(entry.key == signature) {
+				return { .indices = detail::CANDIDATE_DB + entry.first, .count = entry.count };
+			}
+
+			if(entry.key == detail::EMPTY_SIGNATURE) {
+				return { .indices = nullptr, .count = 0 };
+			}
+
+			slot = (slot + 1) & info.mask;
+		}
+	}
+
+	auto get_instruction_selection(u32 index) -> const instruction_selection& {
+		return detail::SELECTION_DB[index];
+	}
+
+	auto get_instruction_variants(u32 index, u8 operand_index) -> instruction_variants {
+		if(operand_index >= 4) {
+			return { .indices = nullptr, .count = 0 };
+		}
+
+		const variant_range& range = detail::VARIANT_TABLE[index * 4 + operand_index];
+		return { .indices = detail::VARIANT_DB + range.first, .count = range.count };
+	}
+} // namespace baremetal::assembler
@@ -0,0 +1,170 @@
+// index used for instruction selection, generated in tools/tablegen.js alongside the instruction
+// database.
+//
+// every mnemonic is assigned an ID (its position in MNEMONIC_DB), which can be located through a
+// hash of its name. every mnemonic then has its own small hash table, which maps operand signatures
+// (the number of operands and a coarse class of each one of them) to a list of candidate variants.
+// the candidates are kept in database order, and thus the first one which matches the provided
+// operands is the same one which a linear search of the whole mnemonic group would return.
+//
+// additionally, every instruction has a precomputed list of variants for each one of its operands,
+// these only differ in the given (immediate, relocation or memory) operand and are sorted by its
+// bit width, which is what the relaxation passes look for.
+//
+// instruction selection doesn't look at INSTRUCTION_DB itself, but at SELECTION_DB, which only
+// contains the operand types and the broadcast info of every variant (6 bytes per variant instead
+// of 32), hence matching a list of candidates touches far fewer cache lines.
+
+#pragma once
+#include "assembler/instruction/instruction.h"
+
+namespace baremetal::assembler {
+	// has to match get_operand_class in tools/scripts/tablegen.js
+	enum operand_class : u8 {
+		OC_NONE = 0,
+		OC_R8,
+		OC_R16,
+		OC_R32,
+		OC_R64,
+		OC_XMM,
+		OC_YMM,
+		OC_ZMM,
+		OC_K,
+		OC_SREG,
+		OC_ST,
+		OC_REG,  // tmm, mmx, debug, control and bound registers
+		OC_MEM,  // memory, masked memory, vsib and broadcast operands
+		OC_MOFF,
+		OC_IMM,  // immediates and relocations
+	};
+
+	struct mnemonic {
+		u16 first;      // index of the first variant in INSTRUCTION_DB
+		u16 count;      // number of variants
+		u32 signatures; // offset of our signature table in SIGNATURE_TABLE
+		u32 mask;       // size of our signature table - 1
+	};
+
+	struct signature {
+		u32 key;   // operand signature, see get_operand_signature
+		u16 first; // offset of the first candidate in CANDIDATE_DB
+		u16 count; // number of candidates
+	};
+
+	struct instruction_candidates {
+		const u16* indices; // indices into INSTRUCTION_DB, sorted
+		u16 count;
+	};
+
+	// hot part of an instruction, contains everything which instruction selection looks at
+	struct instruction_selection {
+		operand_type operands[4]; // operand types, same as instruction::operands
+		u8 evex;                  // EVEX encoded instruction (only these can use registers above 15)
+		u8 broadcast_n;           // required number of broadcast elements, 0 if there's no broadcast operand
+	};
+
+	struct variant_range {
+		u16 first; // offset of the first variant in VARIANT_DB
+		u8 count;  // number of variants
+	};
+
+	struct instruction_variants {
+		const u16* indices; // indices into INSTRUCTION_DB, sorted by the bit width of the operand
+		u8 count;
+	};
+
+	constexpr u16 INVALID_MNEMONIC = utility::limits<u16>::max();
+
+	[[nodiscard]] constexpr auto get_operand_class(operand_type type) -> operand_class {
+		switch(type) {
+			case OP_NONE: return OC_NONE;
+			case OP_R8:
+			case OP_AL:
+			case OP_CL:   return OC_R8;
+			case OP_R16:
+			case OP_AX:
+			case OP_DX:   return OC_R16;
+			case OP_R32:
+			case OP_EAX:
+			case OP_ECX:
+			case OP_EDX:  return OC_R32;
+			case OP_R64:
+			case OP_RAX:
+			case OP_RCX:  return OC_R64;
+			case OP_XMM:
+			case OP_XMM_K:
+			case OP_XMM_KZ: return OC_XMM;
+			case OP_YMM:
+			case OP_YMM_K:
+			case OP_YMM_KZ: return OC_YMM;
+			case OP_ZMM:
+			case OP_ZMM_K:
+			case OP_ZMM_KZ: return OC_ZMM;
+			case OP_K:
+			case OP_K_K:  return OC_K;
+			case OP_SREG:
+			case OP_ES:
+			case OP_CS:
+			case OP_SS:
+			case OP_DS:
+			case OP_FS:
+			case OP_GS:   return OC_SREG;
+			case OP_ST:
+			case OP_ST0:  return OC_ST;
+			case OP_TMM:
+			case OP_MMX:
+			case OP_DREG:
+			case OP_CREG:
+			case OP_BND:  return OC_REG;
+			case OP_MOFF8:
+			case OP_MOFF16:
+			case OP_MOFF32:
+			case OP_MOFF64: return OC_MOFF;
+			case OP_I8:
+			case OP_I16:
+			case OP_I32:
+			case OP_I64:
+			case OP_REL8:
+			case OP_REL16:
+			case OP_REL32:
+			case OP_REL8_RIP:
+			case OP_REL16_RIP:
+			case OP_REL32_RIP:
+			case OP_HIDDEN: return OC_IMM;
+			default:        return OC_MEM;
+		}
+	}
+
+	// signature of the first 'count' operands, 4 bits per operand class, the count lives in the
+	// upper bits
+	[[nodiscard]] constexpr auto get_operand_signature(const operand* operands, u8 count) -> u32 {
+		u32 signature = static_cast<u32>(count) << 16;
+
+		for(u8 i = 0; i < count; ++i) {
+			signature |= static_cast<u32>(get_operand_class(operands[i].type)) << (i * 4);
+		}
+
+		return signature;
+	}
+
+	// replaces the operand class at the specified index in an existing signature
+	[[nodiscard]] constexpr auto set_signature_class(u32 signature, u8 index, operand_class cl) -> u32 {
+		return (signature & ~(0xfu << (index * 4))) | (static_cast<u32>(cl) << (index * 4));
+	}
+
+	// returns INVALID_MNEMONIC if the name doesn't belong to any mnemonic
+	[[nodiscard]] auto get_mnemonic(const char* name, u64 size) -> u16;
+	[[nodiscard]] auto get_mnemonic(const utility::string_view& name) -> u16;
+	[[nodiscard]] auto get_mnemonic_info(u16 id) -> const mnemonic&;
+
+	// returns all variants of the mnemonic whose operand signature matches, the list is empty if
+	// there are none
+	[[nodiscard]] auto get_instruction_candidates(u16 id, u32 signature) -> instruction_candidates;
+
+	[[nodiscard]] auto get_instruction_selection(u32 index) -> const instruction_selection&;
+
+	// returns all variants of the instruction which only differ in the specified operand (see
+	// is_legal_variant), the list is empty if the operand isn't an immediate, relocation or memory
+	// operand
+	[[nodiscard]] auto get_instruction_variants(u32 index, u8 operand_index) -> instruction_variants;
+} // namespace baremetal::assembler
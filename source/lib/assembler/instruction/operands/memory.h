@@ -22,6 +22,12 @@ namespace baremetal::assembler {
 		scale s = SCALE_1;
 		imm displacement;
 
+		// zero displacements can be omitted, unless they're forced to be 32 bits wide (symbolic
+		// displacements, which are only known once the symbol is resolved)
+		[[nodiscard]] constexpr auto has_displacement() const -> bool {
+			return displacement.value != 0 || displacement.min_bits > 8;
+		}
+
 		[[nodiscard]] constexpr auto has_sse_operands() const -> bool {
 			if(has_base && is_sse_reg(base)) {
 				return true;
@@ -256,7 +256,7 @@ namespace baremetal::assembler {
 		}
 	}
 
-	[[nodiscard]] inline auto is_operand_imm(operand_type op) -> bool {
+	[[nodiscard]] constexpr auto is_operand_imm(operand_type op) -> bool {
 		switch(op) {
 			case OP_I8:
 			case OP_I16:
@@ -275,7 +275,7 @@ namespace baremetal::assembler {
 		}
 	}
 
-	[[nodiscard]] inline auto is_operand_rel(operand_type op) -> bool {
+	[[nodiscard]] constexpr auto is_operand_rel(operand_type op) -> bool {
 		switch(op) {
 			case OP_REL8:
 			case OP_REL16:
@@ -4,6 +4,169 @@
 #include <utility/algorithms/sort.h>
 
 namespace baremetal::assembler {
+	namespace detail {
+		// instructions without symbols and relative operands can be encoded from their operands directly
+		[[nodiscard]] auto requires_resolution(const instruction* inst, const operand* operands) -> bool {
+			for(u8 i = 0; i < inst->operand_count; ++i) {
+				if(operands[i].symbol || is_operand_rel(operands[i].type)) {
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		// a packed operand starts with its type and a flag byte, followed by the fields of its layout
+		// and by its symbol ID, if it references a symbol
+		enum operand_layout : u8 {
+			LAYOUT_REG,  // masked_reg
+			LAYOUT_IMM,  // imm, used by relocations and symbols as well
+			LAYOUT_MOFF, // moff
+			LAYOUT_MEM   // masked_mem, used by every memory operand
+		};
+
+		enum operand_flags : u8 {
+			OPERAND_LAYOUT  = 0b0011,
+			OPERAND_UNKNOWN = 0b0100,
+			OPERAND_SYMBOL  = 0b1000
+		};
+
+		[[nodiscard]] auto get_operand_layout(operand_type type) -> operand_layout {
+			switch(get_operand_class(type)) {
+				case OC_IMM:  return LAYOUT_IMM;
+				case OC_MOFF: return LAYOUT_MOFF;
+				case OC_MEM:  return LAYOUT_MEM;
+				default:      return LAYOUT_REG;
+			}
+		}
+
+		// size of a packed operand in B, including the type and the flags, but not the symbol ID
+		[[nodiscard]] auto get_packed_size(operand_layout layout) -> u8 {
+			switch(layout) {
+				case LAYOUT_REG:  return 2 + 2;
+				case LAYOUT_IMM:  return 2 + 10;
+				case LAYOUT_MOFF: return 2 + 8;
+				case LAYOUT_MEM:  return 2 + 18;
+			}
+
+			return 0;
+		}
+
+		[[nodiscard]] auto get_packed_size(const u8* data) -> u8 {
+			const u8 symbol_size = data[1] & OPERAND_SYMBOL ? sizeof(u32) : 0;
+			return static_cast<u8>(get_packed_size(static_cast<operand_layout>(data[1] & OPERAND_LAYOUT)) + symbol_size);
+		}
+
+		auto pack_immediate(const imm& immediate, u8* data) -> u8* {
+			utility::memcpy(data, &immediate.value, sizeof(u64));
+
+			data[8] = immediate.min_bits;
+			data[9] = immediate.sign;
+
+			return data + 10;
+		}
+
+		auto unpack_immediate(const u8* data, imm& immediate) -> const u8* {
+			utility::memcpy(&immediate.value, data, sizeof(u64));
+
+			immediate.min_bits = data[8];
+			immediate.sign = data[9];
+
+			return data + 10;
+		}
+
+		void pack_operand(const operand& op, u32 symbol, u8* data) {
+			const operand_layout layout = get_operand_layout(op.type);
+
+			data[0] = op.type;
+			data[1] = layout | (op.unknown ? OPERAND_UNKNOWN : 0) | (op.symbol ? OPERAND_SYMBOL : 0);
+			data += 2;
+
+			switch(layout) {
+				case LAYOUT_REG: {
+					data[0] = op.mr.index;
+					data[1] = op.mr.k;
+					data += 2;
+					break;
+				}
+				case LAYOUT_IMM: data = pack_immediate(op.immediate, data); break;
+				case LAYOUT_MOFF: {
+					utility::memcpy(data, &op.memory_offset.value, sizeof(u64));
+					data += 8;
+					break;
+				}
+				case LAYOUT_MEM: {
+					const mem& memory = op.mm.memory;
+
+					data[0] = memory.base.index;
+					data[1] = memory.base.type;
+					data[2] = memory.index.index;
+					data[3] = memory.index.type;
+					data[4] = memory.has_base;
+					data[5] = memory.has_index;
+					data[6] = memory.s;
+					data = pack_immediate(memory.displacement, data + 7);
+					*data++ = op.mm.k;
+					break;
+				}
+			}
+
+			if(op.symbol) {
+				utility::memcpy(data, &symbol, sizeof(u32));
+			}
+		}
+
+		// returns the symbol ID of the operand, symbol_data::NONE if it doesn't reference a symbol
+		auto unpack_operand(const u8* data, const utility::dynamic_array<symbol_data>& symbols, operand& op) -> u32 {
+			const operand_layout layout = static_cast<operand_layout>(data[1] & OPERAND_LAYOUT);
+
+			op.type = static_cast<operand_type>(data[0]);
+			op.unknown = data[1] & OPERAND_UNKNOWN;
+			op.symbol = nullptr;
+
+			const u8 flags = data[1];
+			data += 2;
+
+			switch(layout) {
+				case LAYOUT_REG: {
+					op.mr.index = data[0];
+					op.mr.k = data[1];
+					data += 2;
+					break;
+				}
+				case LAYOUT_IMM: data = unpack_immediate(data, op.immediate); break;
+				case LAYOUT_MOFF: {
+					utility::memcpy(&op.memory_offset.value, data, sizeof(u64));
+					data += 8;
+					break;
+				}
+				case LAYOUT_MEM: {
+					mem& memory = op.mm.memory;
+
+					memory.base = reg(data[0], static_cast<reg_type>(data[1]));
+					memory.index = reg(data[2], static_cast<reg_type>(data[3]));
+					memory.has_base = data[4];
+					memory.has_index = data[5];
+					memory.s = static_cast<scale>(data[6]);
+					data = unpack_immediate(data + 7, memory.displacement);
+					op.mm.k = *data++;
+					break;
+				}
+			}
+
+			if((flags & OPERAND_SYMBOL) == 0) {
+				return symbol_data::NONE;
+			}
+
+			u32 symbol;
+
+			utility::memcpy(&symbol, data, sizeof(u32));
+			op.symbol = symbols[symbol].name;
+
+			return symbol;
+		}
+	} // namespace detail
+
 	auto basic_block::is_instruction_block() const -> bool {
 		switch(type) {
 			case BB_BRANCH:
@@ -26,15 +189,23 @@ namespace baremetal::assembler {
 	}
 
 	void module::stage_instruction(const operand* operands, u32 index, u8 size) {
-		// allocate the new instruction
-		instruction_data* instruction = ctx->allocator.emplace<instruction_data>();
-		utility::memcpy(instruction->operands, operands, sizeof(operand) * 4);
+		instruction_data instruction;
+		u8 count = 0;
+
+		while(count < 4 && operands[count].type != OP_NONE) {
+			count++;
+		}
+
+		instruction.index = index;
+		instruction.operands = static_cast<u32>(m_staged_operands.get_size());
+		instruction.encoded = instruction_data::NOT_ENCODED;
+		instruction.size = size;
+		instruction.operand_count = count;
 
-		instruction->index = index;
-		instruction->size = size;
+		pack_operands(operands, count, m_staged_operands);
 
 		// update the parent section
-		sections[m_section_index].offset += instruction->size;
+		sections[m_section_index].offset += instruction.size;
 
 		// update the staging block
 		m_staged_block.push_back(instruction);
@@ -49,16 +220,19 @@ namespace baremetal::assembler {
 
 		// allocate a new block for our commited instructions
 		auto new_block = ctx->allocator.emplace<basic_block>();
-		u64 inst_size = m_staged_block.get_size() * sizeof(instruction_data*);
+		const u64 inst_size = m_staged_block.get_size() * sizeof(instruction_data);
+		const u64 operand_size = m_staged_operands.get_size();
 
 		new_block->type = ty;
 		new_block->size = sections[m_section_index].current_block_size;
 		
-		// copy over the staged instructions
-		new_block->instructions.data = static_cast<instruction_data**>(ctx->allocator.allocate(inst_size));
+		// copy over the staged instructions and their operands, so that the block owns them
+		new_block->instructions.data = static_cast<instruction_data*>(ctx->allocator.allocate(inst_size));
+		new_block->instructions.operands = operand_size ? static_cast<u8*>(ctx->allocator.allocate(operand_size)) : nullptr;
 		new_block->instructions.size = m_staged_block.get_size();
 
 		utility::memcpy(new_block->instructions.data, m_staged_block.get_data(), inst_size);
+		utility::memcpy(new_block->instructions.operands, m_staged_operands.get_data(), operand_size);
 
 		// update block offsets
 		sections[m_section_index].size += sections[m_section_index].current_block_size;
@@ -75,28 +249,33 @@ namespace baremetal::assembler {
 		new_block->type = BB_LABEL;
 		new_block->size = sections[m_section_index].current_block_size;
 		new_block->label.name = name;
+		new_block->label.symbol = get_symbol_id(name);
 
 		add_block(new_block);
 	}
 
 	void module::commit_data_block(const utility::dynamic_array<u8>& data) {
+		commit_data_block(data.get_data(), data.get_size());
+	}
+
+	void module::commit_data_block(const u8* data, u64 size) {
 		commit_instruction_block(BB_INSTRUCTION); // commit all staged instructions 
 
 		// allocate a new block for the data segment
 		auto new_block = ctx->allocator.emplace<basic_block>();
-		const u64 block_size = data.get_size() * sizeof(u8);
+		const u64 block_size = size * sizeof(u8);
 
 		new_block->type = BB_DATA;
-		new_block->size = data.get_size();
+		new_block->size = size;
 	
 		// copy over the segment data
 		new_block->data.data = static_cast<u8*>(ctx->allocator.allocate(block_size));
 
-		utility::memcpy(new_block->data.data, data.get_data(), block_size);
+		utility::memcpy(new_block->data.data, data, block_size);
 
 		// update the section offset
-		sections[m_section_index].offset += data.get_size();
-		sections[m_section_index].size += data.get_size();
+		sections[m_section_index].offset += size;
+		sections[m_section_index].size += size;
 
 		add_block(new_block);
 	}
@@ -113,8 +292,103 @@ namespace baremetal::assembler {
 		sections[m_section_index].blocks.push_back(block);
 		m_block_count++;
 
+		// blocks of the following sections move back by one, this only happens when we return to an
+		// earlier section
+		for(u64 i = m_section_index + 1; i < sections.get_size(); ++i) {
+			sections[i].block_offset++;
+		}
+
 		// reset the staging zone
 		m_staged_block.clear();
+		m_staged_operands.clear();
+	}
+
+	void module::pack_operands(const operand* operands, u8 count, utility::dynamic_array<u8>& output) {
+		for(u8 i = 0; i < count; ++i) {
+			const operand& op = operands[i];
+			const u32 symbol = op.symbol ? get_symbol_id(op.symbol) : 0;
+			const u64 offset = output.get_size();
+			const u64 size = detail::get_packed_size(detail::get_operand_layout(op.type)) + (op.symbol ? sizeof(u32) : 0);
+
+			output.resize(offset + size);
+			detail::pack_operand(op, symbol, output.get_data() + offset);
+		}
+	}
+
+	auto module::get_symbol_id(utility::string_view* name) -> u32 {
+		const auto it = m_symbol_ids.find(name);
+
+		if(it != m_symbol_ids.end()) {
+			return it->second;
+		}
+
+		const u32 id = static_cast<u32>(symbols.get_size());
+
+		m_symbol_ids.insert({ name, id });
+		symbols.push_back({ .name = name });
+
+		return id;
+	}
+
+	void module::unpack_operands(const basic_block* block, const instruction_data& data, operand* operands, u32* symbols) const {
+		const u8* packed = block->instructions.operands + data.operands;
+
+		utility::memset(operands, 0, sizeof(operand) * 4);
+
+		for(u8 i = 0; i < 4; ++i) {
+			u32 symbol = symbol_data::NONE;
+
+			if(i < data.operand_count) {
+				symbol = detail::unpack_operand(packed, this->symbols, operands[i]);
+				packed += detail::get_packed_size(packed);
+			}
+
+			if(symbols) {
+				symbols[i] = symbol;
+			}
+		}
+	}
+
+	auto module::get_operand(const basic_block* block, const instruction_data& data, u8 index) const -> operand {
+		ASSERT(index < data.operand_count, "operand index out of range\n");
+		const u8* packed = block->instructions.operands + data.operands;
+		operand op;
+
+		for(u8 i = 0; i < index; ++i) {
+			packed += detail::get_packed_size(packed);
+		}
+
+		detail::unpack_operand(packed, symbols, op);
+		return op;
+	}
+
+	auto module::get_operand_symbol(const basic_block* block, const instruction_data& data, u8 index) const -> u32 {
+		ASSERT(index < data.operand_count, "operand index out of range\n");
+		const u8* packed = block->instructions.operands + data.operands;
+
+		for(u8 i = 0; i < index; ++i) {
+			packed += detail::get_packed_size(packed);
+		}
+
+		if((packed[1] & detail::OPERAND_SYMBOL) == 0) {
+			return symbol_data::NONE;
+		}
+
+		u32 symbol;
+
+		utility::memcpy(&symbol, packed + detail::get_packed_size(packed) - sizeof(u32), sizeof(u32));
+		return symbol;
+	}
+
+	void module::set_operand_type(const basic_block* block, const instruction_data& data, u8 index, operand_type type) {
+		ASSERT(index < data.operand_count, "operand index out of range\n");
+		u8* packed = block->instructions.operands + data.operands;
+
+		for(u8 i = 0; i < index; ++i) {
+			packed += detail::get_packed_size(packed);
+		}
+
+		packed[0] = type;
 	}
 
 	void module::set_section(utility::string_view* name) {
@@ -133,7 +407,12 @@ namespace baremetal::assembler {
 
 		// no section with the specified name was found, create a new one
 		if(new_index == sections.get_size()) {
-			sections.push_back({ .name = name });
+			section new_section;
+
+			new_section.name = name;
+			new_section.block_offset = m_block_count;
+
+			sections.push_back(new_section);
 		}
 
 		// commit the currently staged instructions, we don't want basic blocks to
@@ -144,19 +423,37 @@ namespace baremetal::assembler {
 
 	auto module::declare_symbol(utility::string_view* name, symbol_type type) -> utility::result<void> {
 		section& current_section = sections[m_section_index];
-	
-		// add the new symbol
-		const section::symbol symbol = { current_section.offset, m_block_count, type };
-		const auto result = current_section.symbols.insert({ name, symbol });
+		const u32 id = get_symbol_id(name);
+		symbol_data& symbol = symbols[id];
 
-		// detect symbol redeclaration
-		if(result.second == false) {
+		// detect symbol redeclaration, symbols are shared by all sections
+		if(symbol.declared) {
 			return utility::error("symbol has already been declared before");
 		}
 
+		symbol.position = current_section.offset;
+		symbol.section_index = m_section_index;
+		symbol.type = type;
+		symbol.declared = true;
+
+		// the symbol refers to the block which is committed next, staged instructions are committed
+		// before it
+		symbol.block_index = current_section.blocks.get_size() + (m_staged_block.is_empty() ? 0 : 1);
+
+		current_section.symbols.push_back(id);
 		return SUCCESS;
 	}
 
+	void module::declare_global(utility::string_view* name) {
+		for(const utility::string_view* global : globals) {
+			if(global == name) {
+				return;
+			}
+		}
+
+		globals.push_back(name);
+	}
+
 	void module::print_section_info() {
 		for(const auto& section : sections) {
 			utility::console::print("{}:\n", *section.name);
@@ -166,10 +463,11 @@ namespace baremetal::assembler {
 			if(section.symbols.is_empty() == false) {
 				utility::console::print("  symbols ({}):\n", section.symbols.get_size());
 
-				for(const auto& [symbol, location] : section.symbols) {
-					utility::console::print("    '{}': pos: {}, block: {}, type: ", *symbol, location.position, location.block_index);
+				for(const u32 id : section.symbols) {
+					const symbol_data& symbol = symbols[id];
+					utility::console::print("    '{}': pos: {}, block: {}, type: ", *symbol.name, symbol.position, get_global_block_index(symbol));
 
-					switch(location.type) {
+					switch(symbol.type) {
 						case SYM_REGULAR: utility::console::print("R"); break;
 						case SYM_GLOBAL:  utility::console::print("G"); break;
 						default: ASSERT(false, "unknown symbol type specified\n");
@@ -189,36 +487,88 @@ namespace baremetal::assembler {
 		}
 	}
 
-	auto module::resolve_instruction(const instruction_data* data, const section& section, u64 position) const  -> backend::code {
-		const instruction* inst = &INSTRUCTION_DB[data->index];
-		static operand operands[4];
+	void module::encode_instruction(section& section, instruction_data& data, const operand* operands) {
+		const instruction* inst = &INSTRUCTION_DB[data.index];
 
-		utility::memcpy(operands, data->operands, sizeof(operand) * 4);
+		if(detail::requires_resolution(inst, operands)) {
+			data.encoded = instruction_data::NOT_ENCODED;
+			return;
+		}
+
+		u8 encoded[MAX_INSTRUCTION_SIZE];
+		const u8 size = encoder(inst, operands).emit(encoded);
+
+		// overwrite the previous encoding of the instruction if the new one fits into it, the size of
+		// an encoded instruction is the size of its slot
+		if(data.encoded != instruction_data::NOT_ENCODED && size <= data.size) {
+			utility::memcpy(section.encoded.get_data() + data.encoded, encoded, size);
+			data.size = size;
+			return;
+		}
+
+		const u64 offset = section.encoded.get_size();
+		ASSERT(offset < instruction_data::NOT_ENCODED, "encoding cache overflow\n");
+
+		section.encoded.resize(offset + size);
+		utility::memcpy(section.encoded.get_data() + offset, encoded, size);
+
+		data.size = size;
+		data.encoded = static_cast<u32>(offset);
+	}
+
+	auto module::resolve_instruction(const basic_block* block, const instruction_data& data, const section& section, u64 position, u8* output) const -> u8 {
+		const instruction* inst = &INSTRUCTION_DB[data.index];
+
+		if(data.encoded != instruction_data::NOT_ENCODED) {
+			utility::memcpy(output, section.encoded.get_data() + data.encoded, data.size);
+			return data.size;
+		}
+
+		operand operands[4];
+		u32 ids[4];
+
+		unpack_operands(block, data, operands, ids);
+
+		if(!detail::requires_resolution(inst, operands)) {
+			return encoder(inst, operands).emit(output);
+		}
 
 		// resolve symbols
 		for(u8 i = 0; i < inst->operand_count; ++i) {
-			if(operands[i].symbol) {
-				auto symbol_it = section.symbols.find(operands[i].symbol);
+			if(ids[i] != symbol_data::NONE) {
+				const symbol_data& symbol = symbols[ids[i]];
 				i64 value = 0;
 
+				ASSERT(symbol.declared, "unknown symbol '{}'\n", *symbol.name);
+
+				// symbolic memory operands use the absolute symbol position as their displacement, which
+				// has to stay 32 bits wide, since the size of the instruction has already been decided
+				if(is_operand_mem(operands[i].type)) {
+					imm& displacement = operands[i].memory.displacement;
+
+					displacement = imm(static_cast<i64>(displacement.value + get_global_symbol_position(symbol)));
+					displacement.min_bits = 32;
+					continue;
+				}
+
 				switch(operands[i].type) {
 					// immediates are absolute
 					case OP_I8:
 					case OP_I16:
 					case OP_I32:
-					case OP_I64: value = get_global_symbol_position(operands[i].symbol); break;
+					case OP_I64: value = get_global_symbol_position(symbol); break;
 					// relocations are relative
 					case OP_REL32:
 					case OP_REL8:
 					case OP_REL16_RIP:
 					case OP_REL8_RIP: {
-						if(symbol_it == section.symbols.end()) {
+						if(&sections[symbol.section_index] != &section) {
 							// global symbol position - (section position + instruction position + instruction size)
-							value = get_global_symbol_position(operands[i].symbol) - (section.position + position + data->size);
+							value = get_global_symbol_position(symbol) - (section.position + position + data.size);
 						}
 						else {
 							// symbol position - (instruction position + instruction size)
-							value = symbol_it->second.position - (position + data->size);
+							value = symbol.position - (position + data.size);
 						}
 
 						break;
@@ -230,62 +580,96 @@ namespace baremetal::assembler {
 			}
 			else if(is_operand_rip_rel(operands[i].type)) {
 				const i64 value = operands[i].immediate.value;
-				operands[i].immediate = value - data->size;
+				operands[i].immediate = value - data.size;
 			}
 			else if(is_operand_rel(operands[i].type)) {
 				const i64 value = operands[i].immediate.value;
-				operands[i].immediate = value - (position + data->size);
+				operands[i].immediate = value - (position + data.size);
 			}
 		}
 
-		return backend::emit_instruction(inst, operands);
+		return encoder(inst, operands).emit(output);
 	}
 
-	auto module::get_block_at_index(u64 i) const -> basic_block* {
-		const u64 original_i = i; // debugging
+	auto module::resolve_instruction_block(const basic_block* block, const section& section, u64 position, u8* output) const -> u64 {
+		ASSERT(block->is_instruction_block(), "block does not contain instructions\n");
+		const instruction_data* instructions = block->instructions.data;
+		const u64 count = block->instructions.size;
+		u64 size = 0;
+		u64 i = 0;
+
+		while(i < count) {
+			if(instructions[i].encoded == instruction_data::NOT_ENCODED) {
+				const u8 written = resolve_instruction(block, instructions[i], section, position + size, output + size);
+
+				ASSERT(written == instructions[i].size, "instruction size mismatch\n");
+				size += written;
+				i++;
+				continue;
+			}
+
+			// instructions are encoded in order, hence consecutive cached instructions usually form a
+			// run in the encoding cache, which can be copied all at once
+			const u64 start = instructions[i].encoded;
+			u64 end = start + instructions[i].size;
 
-		for(const section& section : sections) {
-			if(i < section.blocks.get_size()) {
-				return section.blocks[i];
+			for(i++; i < count && instructions[i].encoded == end; ++i) {
+				end += instructions[i].size;
 			}
 
-			i -= section.blocks.get_size();
+			utility::memcpy(output + size, section.encoded.get_data() + start, end - start);
+			size += end - start;
 		}
 
-		ASSERT(false, "get_block_at_index: block at index {} is out of bounds\n", original_i);
-		SUPPRESS_C4100(original_i);
+		return size;
+	}
 
-		return nullptr;
+	auto module::get_global_symbol_position(const symbol_data& symbol) const -> u64 {
+		// section position + symbol position (relative to the parent section)
+		return sections[symbol.section_index].position + symbol.position;
 	}
 
-	auto module::get_global_symbol_position(utility::string_view* name) const -> u64 {
-		for(u64 i = 0; i < sections.get_size(); ++i) {
-			const auto& section = sections[i];
-			const auto it = section.symbols.find(name);
-	
-			if(it != section.symbols.end()) {
-				// section position + symbol position (relative to the parent section)
-				return section.position + it->second.position;
+	auto module::verify_symbols() const -> utility::result<void> {
+		for(const symbol_data& symbol : symbols) {
+			if(!symbol.declared) {
+				return utility::error("reference to an undeclared symbol");
 			}
 		}
-	
-		ASSERT(false, "unknown symbol '{}' specified\n", *name);
-		return 0;
+
+		return SUCCESS;
 	}
 
-	auto module::get_symbol(utility::string_view* name) const -> section::symbol {
-		ASSERT(name != nullptr, "symbol is nullptr\n");
+	auto module::find_symbol(utility::string_view* name) const -> const symbol_data* {
+		const auto it = m_symbol_ids.find(name);
 
-		for(const section& section : sections) {
-			const auto it = section.symbols.find(name);
+		if(it == m_symbol_ids.end() || !symbols[it->second].declared) {
+			return nullptr;
+		}
 
-			if(it != section.symbols.end()) {
-				return it->second;
+		return &symbols[it->second];
+	}
+
+	auto module::get_global_block_index(const symbol_data& symbol) const -> u64 {
+		return sections[symbol.section_index].block_offset + symbol.block_index;
+	}
+
+	auto module::get_symbol_block(const symbol_data& symbol) const -> basic_block* {
+		return sections[symbol.section_index].blocks[symbol.block_index];
+	}
+
+	auto module::get_next_block(u64 section_index, u64 block_index) const -> basic_block* {
+		if(block_index + 1 < sections[section_index].blocks.get_size()) {
+			return sections[section_index].blocks[block_index + 1];
+		}
+
+		// skip sections without any blocks
+		for(u64 i = section_index + 1; i < sections.get_size(); ++i) {
+			if(!sections[i].blocks.is_empty()) {
+				return sections[i].blocks[0];
 			}
 		}
 
-		ASSERT(false, "unknown symbol '{}'\n", *name);
-		return {};
+		return nullptr;
 	}
 
 	auto module::get_block_count() const -> u64 {
@@ -301,7 +685,7 @@ namespace baremetal::assembler {
 			for(const basic_block* block : section.blocks) {
 				if(block->is_instruction_block()) {
 					for(u64 i = 0; i < block->instructions.size; ++i) {
-						section.size += block->instructions.data[i]->size;
+						section.size += block->instructions.data[i].size;
 					}
 				}
 				else if(block->is_data_block()){
@@ -309,7 +693,7 @@ namespace baremetal::assembler {
 				}
 				else {
 					// labels
-					section.symbols[block->label.name].position = section.size;
+					symbols[block->label.symbol].position = section.size;
 				}
 			}
 
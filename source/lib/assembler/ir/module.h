@@ -7,7 +7,8 @@
 //     - instructions / labels / data
 //
 // - sections split up individual assembly sections, each sections has a number of symbols, we can't optimize
-//   symbolic references across sections.
+//   symbolic references across sections. symbols themselves are stored in a single table shared by all
+//   sections (module::symbols), and are referenced by their index in this table (symbol ID).
 // - each section contains a list of basic blocks, which represent the program at that point, in order, each 
 //   basic block can contain one of the following: 
 //   - contiguous list of instructions (list of instructions with none of the following in between them) 
@@ -23,12 +24,27 @@
 namespace baremetal::assembler {
 	using namespace utility::types;
 
-	struct instruction_data {
+	// instruction with its operands in their full form, used wherever instructions exist outside of a
+	// module (the decoder, the module log)
+	struct unpacked_instruction {
 		operand operands[4]; // instruction operands
 		u32 index;           // index in INSTRUCTION_DB
 		u8 size;             // size of the encoded instruction in B
 	};
 
+	// instruction within a module, its operands are packed into the operand storage of the parent
+	// block (see module::pack_operands), where every operand only takes up as many bytes as its kind
+	// needs, and symbols are referenced by their ID (see module::symbols)
+	struct instruction_data {
+		static constexpr u32 NOT_ENCODED = utility::limits<u32>::max();
+
+		u32 index;                 // index in INSTRUCTION_DB
+		u32 operands;              // offset of the packed operands in instruction_block::operands
+		u32 encoded = NOT_ENCODED; // offset of the cached encoding in section::encoded, see module::encode_instruction
+		u8 size;                   // size of the encoded instruction in B
+		u8 operand_count;          // number of packed operands
+	};
+
 	enum basic_block_type : u8 {
 		BB_INSTRUCTION, // block containing at least one instruction
 		BB_BRANCH,      // subset of BB_INSTRUCTION, ends with branch/jump instruction
@@ -38,12 +54,14 @@ namespace baremetal::assembler {
 
 	struct basic_block {
 		struct instruction_block {
-			instruction_data** data; // instructions 
-			u64 size;                // number of instructions
+			instruction_data* data; // instructions, stored contiguously
+			u8* operands;           // packed operands of the instructions
+			u64 size;               // number of instructions
 		};
 
 		struct label_block {
 			utility::string_view* name;
+			u32 symbol; // ID of the label symbol
 		};
 
 		struct data_block {
@@ -73,22 +91,33 @@ namespace baremetal::assembler {
 		SYM_GLOBAL
 	};
 
-	struct section {
-		struct symbol {
-			u64 position;    // offset within the local section
-			u64 block_index; // global block index (across all sections)
-			symbol_type type = SYM_REGULAR;
-		};
+	// symbols are added to the symbol table the first time they're declared or referenced, hence the
+	// table can contain symbols which haven't been declared (yet)
+	struct symbol_data {
+		static constexpr u32 NONE = utility::limits<u32>::max();
+
+		utility::string_view* name;
+		u64 position = 0;      // offset within the parent section
+		u64 section_index = 0; // index of the parent section
+		u64 block_index = 0;   // index of the block within the parent section
+		symbol_type type = SYM_REGULAR;
+		bool declared = false;
+	};
 
+	struct section {
 		utility::string_view* name;
 
-		u64 position = 0;  // aligned section position
-		u64 offset = 0;    // current offset of the section, only used when a section is being constructed
-		u64 size = 0;      // unaligned size of this section, in bytes
+		u64 position = 0;     // aligned section position
+		u64 offset = 0;       // current offset of the section, only used when a section is being constructed
+		u64 size = 0;         // unaligned size of this section, in bytes
+		u64 block_offset = 0; // global index of the first block, equal to the block count of the preceding sections
 
-		utility::map<utility::string_view*, symbol> symbols;
+		utility::dynamic_array<u32> symbols; // IDs of the symbols declared in this section
 		utility::dynamic_array<basic_block*> blocks;
 
+		// encodings of the instructions which don't have to be resolved, in the order they were encoded in
+		utility::dynamic_array<u8> encoded;
+
 		// only relevant when constructing the module
 		u64 current_block_position = 0;
 		u64 current_block_size = 0;
@@ -104,26 +133,75 @@ namespace baremetal::assembler {
 		void commit_instruction_block(basic_block_type ty);
 		void commit_label_block(utility::string_view* name);
 		void commit_data_block(const utility::dynamic_array<u8>& data);
+		void commit_data_block(const u8* data, u64 size);
 		
 		[[nodiscard]] auto declare_symbol(utility::string_view* name, symbol_type type = SYM_REGULAR) -> utility::result<void>;
-		// TODO: predeclare_symbol for global symbols
+
+		// marks the symbol as exported, the symbol itself can be declared before or after this call
+		void declare_global(utility::string_view* name);
 
 		void set_section(utility::string_view* name);
 
 		// misc
-		[[nodiscard]] auto get_global_symbol_position(utility::string_view* name) const -> u64;
-		[[nodiscard]] auto get_symbol(utility::string_view* name) const -> section::symbol;
-		[[nodiscard]] auto get_block_at_index(u64 i) const -> basic_block*;
 		[[nodiscard]] auto get_block_count() const -> u64;
 
+		// returns the ID of the symbol, symbols get their IDs in the order in which they're first
+		// declared or referenced
+		[[nodiscard]] auto get_symbol_id(utility::string_view* name) -> u32;
+
+		// checks that every referenced symbol has been declared, which every pass relies on
+		[[nodiscard]] auto verify_symbols() const -> utility::result<void>;
+
+		// returns nullptr if the symbol hasn't been declared
+		[[nodiscard]] auto find_symbol(utility::string_view* name) const -> const symbol_data*;
+		[[nodiscard]] auto get_global_symbol_position(const symbol_data& symbol) const -> u64;
+
+		// blocks are globally indexed in the order in which they're laid out (section by section)
+		[[nodiscard]] auto get_global_block_index(const symbol_data& symbol) const -> u64;
+		[[nodiscard]] auto get_symbol_block(const symbol_data& symbol) const -> basic_block*;
+
+		// returns the block which follows the specified block in the layout of the module, the last
+		// block of a section is followed by the first block of the next section, returns nullptr for
+		// the last block of the module
+		[[nodiscard]] auto get_next_block(u64 section_index, u64 block_index) const -> basic_block*;
+
 		void recalculate_block_sizes();
 		void print_section_info();
 
-		[[nodiscard]] auto resolve_instruction(const instruction_data* data, const section& section, u64 position) const -> backend::code;
+		// packed operands, 'operands' always holds 4 operands, the ones past the packed ones are cleared,
+		// 'symbols' optionally receives the symbol IDs of the operands (symbol_data::NONE for operands
+		// without a symbol)
+		void unpack_operands(const basic_block* block, const instruction_data& data, operand* operands, u32* symbols = nullptr) const;
+		[[nodiscard]] auto get_operand(const basic_block* block, const instruction_data& data, u8 index) const -> operand;
+		[[nodiscard]] auto get_operand_symbol(const basic_block* block, const instruction_data& data, u8 index) const -> u32;
+
+		// retypes a packed operand in place, operands can be retyped between kinds (ie. a symbolic
+		// memory operand can become a relocation), but they keep the fields of their original kind
+		void set_operand_type(const basic_block* block, const instruction_data& data, u8 index, operand_type type);
+
+		// encodes instructions which don't reference symbols or relative locations into the encoding
+		// cache of their section, from which every later emit copies them, has to be called again
+		// whenever the variant or the operands of the instruction change, the new encoding replaces the
+		// previous one in place if it fits, 'operands' are the unpacked operands of the instruction
+		void encode_instruction(section& section, instruction_data& data, const operand* operands);
+
+		// resolves symbols and encodes the instruction into 'output', returns the size of the encoded
+		// instruction
+		auto resolve_instruction(const basic_block* block, const instruction_data& data, const section& section, u64 position, u8* output) const -> u8;
+
+		// resolves and encodes every instruction of an instruction block into 'output', which has to
+		// be large enough to hold the entire block, returns the number of bytes written, runs of
+		// cached encodings are copied at once, only the remaining instructions go through the encoder
+		auto resolve_instruction_block(const basic_block* block, const section& section, u64 position, u8* output) const -> u64;
 	private:
 		void add_block(basic_block* block);
+
+		// appends the packed form of the first 'count' operands to 'output'
+		void pack_operands(const operand* operands, u8 count, utility::dynamic_array<u8>& output);
 	public:
 		utility::dynamic_array<section> sections; // all sections, in order of declaration ([0] = '.text') 
+		utility::dynamic_array<utility::string_view*> globals; // exported symbols, in order of declaration
+		utility::dynamic_array<symbol_data> symbols; // symbol table, indexed by symbol ID
 		context* ctx;
 	private:
 		u64 m_section_index = 0; // index of the current section, used when constructing the module
@@ -132,6 +210,9 @@ namespace baremetal::assembler {
 		// when creating the module instructions are added (staged) one by one (stage_instruction), once we're done
 		// with these instructions we submit (commit) the staged block and that way we finalize it
 		// staged -> commited -> finalized
-		utility::dynamic_array<instruction_data*> m_staged_block;
+		utility::dynamic_array<instruction_data> m_staged_block;
+		utility::dynamic_array<u8> m_staged_operands;
+
+		utility::map<utility::string_view*, u32> m_symbol_ids; // symbol name -> symbol ID
 	};
 } // namespace baremetal::assembler
@@ -0,0 +1,74 @@
+#include "module_log.h"
+
+namespace baremetal::assembler {
+	void module_log::stage_instruction(const operand* operands, u32 index, u8 size) {
+		unpacked_instruction instruction;
+
+		utility::memcpy(instruction.operands, operands, sizeof(operand) * 4);
+		instruction.index = index;
+		instruction.size = size;
+
+		m_events.push_back({ .type = EVENT_STAGE_INSTRUCTION, .kind = 0, .index = m_instructions.get_size(), .size = 0, .name = nullptr });
+		m_instructions.push_back(instruction);
+	}
+
+	void module_log::commit_instruction_block(basic_block_type ty) {
+		m_events.push_back({ .type = EVENT_COMMIT_INSTRUCTION_BLOCK, .kind = ty, .index = 0, .size = 0, .name = nullptr });
+	}
+
+	void module_log::commit_label_block(utility::string_view* name) {
+		m_events.push_back({ .type = EVENT_COMMIT_LABEL_BLOCK, .kind = 0, .index = 0, .size = 0, .name = name });
+	}
+
+	void module_log::commit_data_block(const utility::dynamic_array<u8>& data) {
+		m_events.push_back({ .type = EVENT_COMMIT_DATA_BLOCK, .kind = 0, .index = m_data.get_size(), .size = data.get_size(), .name = nullptr });
+
+		for(const u8 byte : data) {
+			m_data.push_back(byte);
+		}
+	}
+
+	void module_log::declare_symbol(utility::string_view* name, symbol_type type) {
+		m_events.push_back({ .type = EVENT_DECLARE_SYMBOL, .kind = type, .index = 0, .size = 0, .name = name });
+	}
+
+	void module_log::declare_global(utility::string_view* name) {
+		m_events.push_back({ .type = EVENT_DECLARE_GLOBAL, .kind = 0, .index = 0, .size = 0, .name = name });
+	}
+
+	void module_log::set_section(utility::string_view* name) {
+		m_events.push_back({ .type = EVENT_SET_SECTION, .kind = 0, .index = 0, .size = 0, .name = name });
+	}
+
+	auto module_log::replay(module& target) const -> utility::result<void> {
+		utility::string_interner& strings = target.ctx->strings;
+
+		for(const event& e : m_events) {
+			switch(e.type) {
+				case EVENT_STAGE_INSTRUCTION: {
+					const unpacked_instruction& instruction = m_instructions[e.index];
+					operand operands[4];
+
+					utility::memcpy(operands, instruction.operands, sizeof(operand) * 4);
+
+					for(operand& op : operands) {
+						if(op.symbol) {
+							op.symbol = strings.add(*op.symbol);
+						}
+					}
+
+					target.stage_instruction(operands, instruction.index, instruction.size);
+					break;
+				}
+				case EVENT_COMMIT_INSTRUCTION_BLOCK: target.commit_instruction_block(static_cast<basic_block_type>(e.kind)); break;
+				case EVENT_COMMIT_LABEL_BLOCK:       target.commit_label_block(strings.add(*e.name)); break;
+				case EVENT_COMMIT_DATA_BLOCK:        target.commit_data_block(m_data.get_data() + e.index, e.size); break;
+				case EVENT_DECLARE_SYMBOL:           TRY(target.declare_symbol(strings.add(*e.name), static_cast<symbol_type>(e.kind))); break;
+				case EVENT_DECLARE_GLOBAL:           target.declare_global(strings.add(*e.name)); break;
+				case EVENT_SET_SECTION:              target.set_section(strings.add(*e.name)); break;
+			}
+		}
+
+		return SUCCESS;
+	}
+} // namespace baremetal::assembler
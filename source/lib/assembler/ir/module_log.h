@@ -0,0 +1,51 @@
+// sequential record of module construction calls. used by the parallel frontend, where every chunk
+// of the source file is parsed into its own log, independently of the other chunks. once parsed,
+// the logs are replayed, in order, into the final module, which results in the exact same module
+// (sections, basic blocks and symbols) as parsing the entire file serially would.
+
+#pragma once
+#include "assembler/ir/module.h"
+
+namespace baremetal::assembler {
+	class module_log {
+	public:
+		module_log() = default;
+
+		// module construction, mirrors the module interface
+		void stage_instruction(const operand* operands, u32 index, u8 size);
+
+		void commit_instruction_block(basic_block_type ty);
+		void commit_label_block(utility::string_view* name);
+		void commit_data_block(const utility::dynamic_array<u8>& data);
+
+		void declare_symbol(utility::string_view* name, symbol_type type = SYM_REGULAR);
+		void declare_global(utility::string_view* name);
+		void set_section(utility::string_view* name);
+
+		// replay all recorded calls into the target module, names are reinterned into the context
+		// of the target module, since the ones we hold belong to the context of the chunk parser
+		[[nodiscard]] auto replay(module& target) const -> utility::result<void>;
+	private:
+		enum event_type : u8 {
+			EVENT_STAGE_INSTRUCTION,
+			EVENT_COMMIT_INSTRUCTION_BLOCK,
+			EVENT_COMMIT_LABEL_BLOCK,
+			EVENT_COMMIT_DATA_BLOCK,
+			EVENT_DECLARE_SYMBOL,
+			EVENT_DECLARE_GLOBAL,
+			EVENT_SET_SECTION
+		};
+
+		struct event {
+			event_type type;
+			u8 kind;                    // basic_block_type, or symbol_type
+			u64 index;                  // index into m_instructions, or offset into m_data
+			u64 size;                   // size of a data block
+			utility::string_view* name; // label, symbol or section name
+		};
+
+		utility::dynamic_array<event> m_events;
+		utility::dynamic_array<unpacked_instruction> m_instructions;
+		utility::dynamic_array<u8> m_data;
+	};
+} // namespace baremetal::assembler
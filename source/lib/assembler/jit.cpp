@@ -0,0 +1,248 @@
+#include "jit.h"
+
+#include "assembler/frontend.h"
+
+#include "assembler/passes/cfg_analyze_pass.h"
+#include "assembler/passes/inst_size_minimize_pass.h"
+#include "assembler/passes/symbolic_minimize_pass.h"
+#include "assembler/passes/emit/emit_binary_pass.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
+
+namespace baremetal::assembler {
+	namespace detail {
+		[[nodiscard]] auto get_page_size() -> u64 {
+#ifndef _WIN32
+			return static_cast<u64>(sysconf(_SC_PAGESIZE));
+#else
+			SYSTEM_INFO info;
+			GetSystemInfo(&info);
+			return info.dwPageSize;
+#endif
+		}
+
+		// maps a readable and writable region, returns nullptr on failure
+		[[nodiscard]] auto map_memory(u64 size) -> u8* {
+#ifndef _WIN32
+			void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			return data == MAP_FAILED ? nullptr : static_cast<u8*>(data);
+#else
+			return static_cast<u8*>(VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+#endif
+		}
+
+		void unmap_memory(u8* data, u64 size) {
+#ifndef _WIN32
+			munmap(data, size);
+#else
+			SUPPRESS_C4100(size);
+			VirtualFree(data, 0, MEM_RELEASE);
+#endif
+		}
+
+		// flips the region between RW and RX, returns false on failure
+		[[nodiscard]] auto protect_memory(u8* data, u64 size, bool executable) -> bool {
+#ifndef _WIN32
+			return mprotect(data, size, executable ? PROT_READ | PROT_EXEC : PROT_READ | PROT_WRITE) == 0;
+#else
+			DWORD previous;
+
+			if(!VirtualProtect(data, size, executable ? PAGE_EXECUTE_READ : PAGE_READWRITE, &previous)) {
+				return false;
+			}
+
+			return !executable || FlushInstructionCache(GetCurrentProcess(), data, size);
+#endif
+		}
+
+		[[nodiscard]] auto is_same_name(const utility::dynamic_string& a, const utility::string_view& b) -> bool {
+			if(a.get_size() != b.get_size()) {
+				return false;
+			}
+
+			for(u64 i = 0; i < a.get_size(); ++i) {
+				if(a[i] != b[i]) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+	} // namespace detail
+
+	auto jit_code::get_symbol(const utility::string_view& name) const -> void* {
+		for(const symbol& symbol : symbols) {
+			if(detail::is_same_name(symbol.name, name)) {
+				return data + symbol.position;
+			}
+		}
+
+		return nullptr;
+	}
+
+	jit::~jit() {
+		for(const region& region : m_regions) {
+			detail::unmap_memory(region.data, region.capacity);
+		}
+	}
+
+	auto jit::assemble(const utility::string_view& source) -> utility::result<jit_code> {
+		// the module references the context of the frontend, which has to outlive it
+		frontend frontend(source);
+		TRY(module module, frontend.parse());
+
+		pass::cfg_analyze(module);
+		pass::inst_size_minimize(module);
+		pass::symbolic_minimize(module);
+
+		return assemble(module);
+	}
+
+	auto jit::assemble(const module& module) -> utility::result<jit_code> {
+		jit_code code;
+		TRY(module.verify_symbols());
+
+		// locate the global symbols first, so that we don't touch any memory for invalid modules
+		for(utility::string_view* name : module.globals) {
+			const symbol_data* symbol = module.find_symbol(name);
+
+			if(symbol == nullptr) {
+				return utility::error("undeclared global symbol");
+			}
+
+			code.symbols.push_back({ .name = utility::dynamic_string(*name), .position = module.get_global_symbol_position(*symbol) });
+		}
+
+		TRY(code.relocations, get_relocations(module));
+
+		code.size = pass::get_binary_size(module);
+		TRY(region* region, acquire_region(code.size));
+
+		code.data = region->data;
+		code.capacity = region->capacity;
+
+		pass::emit_binary(module, code.data);
+
+		// absolute references are emitted relative to the start of the code
+		for(const u64 offset : code.relocations) {
+			u64 address;
+
+			utility::memcpy(&address, code.data + offset, sizeof(u64));
+			address += reinterpret_cast<u64>(code.data);
+			utility::memcpy(code.data + offset, &address, sizeof(u64));
+		}
+
+		if(!detail::protect_memory(code.data, code.capacity, true)) {
+			region->free = true;
+			return utility::error("cannot make the code executable");
+		}
+
+		return code;
+	}
+
+	void jit::release(jit_code& code) {
+		ASSERT(code.data != nullptr, "code has already been released\n");
+
+		for(region& region : m_regions) {
+			if(region.data == code.data) {
+				region.free = true;
+				break;
+			}
+		}
+
+		code.data = nullptr;
+		code.size = 0;
+		code.capacity = 0;
+		code.symbols.clear();
+		code.relocations.clear();
+	}
+
+	auto jit::get_relocations(const module& module) -> utility::result<utility::dynamic_array<u64>> {
+		utility::dynamic_array<u64> relocations;
+		u64 size = 0;
+
+		// walk the instructions in the same order as emit_binary
+		for(const section& section : module.sections) {
+			size = utility::align(size, 4);
+
+			for(const basic_block* block : section.blocks) {
+				if(block->is_data_block()) {
+					size += block->size;
+					continue;
+				}
+
+				if(!block->is_instruction_block()) {
+					continue;
+				}
+
+				for(u64 i = 0; i < block->instructions.size; ++i) {
+					const instruction_data& inst = block->instructions.data[i];
+					const instruction& selected = INSTRUCTION_DB[inst.index];
+					operand operands[4];
+					u32 symbols[4];
+
+					size += inst.size;
+
+					if(inst.encoded != instruction_data::NOT_ENCODED) {
+						continue; // no symbols
+					}
+
+					module.unpack_operands(block, inst, operands, symbols);
+
+					for(u8 j = 0; j < selected.operand_count; ++j) {
+						if(symbols[j] == symbol_data::NONE || is_operand_rel(selected.operands[j])) {
+							continue;
+						}
+
+						// only 64-bit immediates can hold an address, symbolic memory displacements are
+						// 32 bits wide and absolute
+						if(selected.operands[j] != OP_I64) {
+							return utility::error("absolute symbol reference cannot hold the address of the code");
+						}
+
+						relocations.push_back(size - inst.size + detail::get_immediate_offset(&selected, j, inst.size));
+					}
+				}
+			}
+		}
+
+		return relocations;
+	}
+
+	auto jit::acquire_region(u64 size) -> utility::result<region*> {
+		// reuse the smallest released region which fits
+		region* best = nullptr;
+
+		for(region& region : m_regions) {
+			if(region.free && region.capacity >= size && (best == nullptr || region.capacity < best->capacity)) {
+				best = &region;
+			}
+		}
+
+		if(best) {
+			// released regions are still executable
+			if(!detail::protect_memory(best->data, best->capacity, false)) {
+				return utility::error("cannot make the code writable");
+			}
+
+			best->free = false;
+			return best;
+		}
+
+		// empty modules still get a region, so that every piece of code has a unique address
+		const u64 capacity = utility::align(size == 0 ? 1 : size, detail::get_page_size());
+		u8* data = detail::map_memory(capacity);
+
+		if(data == nullptr) {
+			return utility::error("cannot map executable memory");
+		}
+
+		m_regions.push_back({ .data = data, .capacity = capacity, .free = false });
+		return &m_regions[m_regions.get_size() - 1];
+	}
+} // namespace baremetal::assembler
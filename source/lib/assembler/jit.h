@@ -0,0 +1,75 @@
+// in-process JIT, assembles source code directly into executable memory and hands out pointers to
+// its global symbols.
+//
+// code lives in page aligned regions, which are never writable and executable at the same time: a
+// region is mapped as RW, the module is emitted into it, and the region is then flipped to RX.
+// released regions are flipped back to RW once they're reused by a later module which fits into
+// them, and are only unmapped once the jit itself is destroyed.
+//
+// the module is emitted the same way emit_binary emits it, hence relative references (branches,
+// rip-relative memory operands) are valid anywhere. absolute symbol references (ie. 'mov rax,
+// label') are emitted relative to the start of the region, same as they are in a flat binary, and
+// are then relocated to the address of the region. only 64-bit immediates can hold an address,
+// modules with narrower absolute references are rejected. this includes 32-bit immediates, and
+// symbolic memory operands (ie. 'mov qword [label], 1'), whose displacements are absolute disp32s
+// and aren't converted to rip-relative ones - load the address into a register first instead.
+
+#pragma once
+#include "assembler/ir/module.h"
+
+namespace baremetal::assembler {
+	struct jit_code {
+		struct symbol {
+			utility::dynamic_string name;
+			u64 position; // offset from the start of the code
+		};
+
+		// returns nullptr if there is no global symbol with the specified name
+		[[nodiscard]] auto get_symbol(const utility::string_view& name) const -> void*;
+
+		template<typename type>
+		[[nodiscard]] auto get_function(const utility::string_view& name) const -> type {
+			return reinterpret_cast<type>(get_symbol(name));
+		}
+
+		u8* data = nullptr; // start of the region
+		u64 size = 0;       // size of the emitted code, in bytes
+		u64 capacity = 0;   // size of the region, in bytes
+
+		utility::dynamic_array<symbol> symbols;  // global symbols, in order of declaration
+		utility::dynamic_array<u64> relocations; // offsets of the relocated 64-bit absolute references
+	};
+
+	class jit {
+	public:
+		jit() = default;
+		~jit();
+
+		jit(const jit&) = delete;
+		auto operator=(const jit&) -> jit& = delete;
+
+		// parses and optimizes the source, and emits it into executable memory
+		[[nodiscard]] auto assemble(const utility::string_view& source) -> utility::result<jit_code>;
+
+		// emits an already optimized module into executable memory
+		[[nodiscard]] auto assemble(const module& module) -> utility::result<jit_code>;
+
+		// returns the region of the code to the jit, pointers into the code are invalidated
+		void release(jit_code& code);
+
+		// offsets of the absolute symbol references of the module, which have to be relocated to the
+		// address of the code, fails if an absolute reference is too narrow to hold an address
+		[[nodiscard]] static auto get_relocations(const module& module) -> utility::result<utility::dynamic_array<u64>>;
+	private:
+		struct region {
+			u8* data;
+			u64 capacity;
+			bool free; // released, ready to be reused
+		};
+
+		// returns a writable region which can hold at least 'size' bytes
+		[[nodiscard]] auto acquire_region(u64 size) -> utility::result<region*>;
+	private:
+		utility::dynamic_array<region> m_regions; // every region we've mapped
+	};
+} // namespace baremetal::assembler
@@ -1,15 +1,583 @@
 #include "lexer.h"
 
-#include <utility/containers/map.h>
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 namespace baremetal::assembler {
+	namespace detail {
+		struct keyword {
+			const char* name;
+			token_type token;
+		};
+
+		constexpr keyword g_keywords[] = {
+			// registers
+			{ "cr0",   TOK_CR0,   },
+			{ "cr1",   TOK_CR1,   },
+			{ "cr2",   TOK_CR2,   },
+			{ "cr3",   TOK_CR3,   },
+			{ "cr4",   TOK_CR4,   },
+			{ "cr8",   TOK_CR8,   },
+			{ "dr0",   TOK_DR0,   },
+			{ "dr1",   TOK_DR1,   },
+			{ "dr2",   TOK_DR2,   },
+			{ "dr3",   TOK_DR3,   },
+			{ "dr4",   TOK_DR4,   },
+			{ "dr5",   TOK_DR5,   },
+			{ "dr6",   TOK_DR6,   },
+			{ "dr7",   TOK_DR7,   },
+			{ "k1",    TOK_K1,    },
+			{ "k2",    TOK_K2,    },
+			{ "k3",    TOK_K3,    },
+			{ "k4",    TOK_K4,    },
+			{ "k5",    TOK_K5,    },
+			{ "k6",    TOK_K6,    },
+			{ "k7",    TOK_K7,    },
+			{ "z",     TOK_Z,     },
+			{ "es",    TOK_ES,    },
+			{ "cs",    TOK_CS,    },
+			{ "ss",    TOK_SS,    },
+			{ "ds",    TOK_DS,    },
+			{ "fs",    TOK_FS,    },
+			{ "gs",    TOK_GS,    },
+			{ "st0",   TOK_ST0,   },
+			{ "st1",   TOK_ST1,   },
+			{ "st2",   TOK_ST2,   },
+			{ "st3",   TOK_ST3,   },
+			{ "st4",   TOK_ST4,   },
+			{ "st5",   TOK_ST5,   },
+			{ "st6",   TOK_ST6,   },
+			{ "st7",   TOK_ST7,   },
+			{ "bnd0",  TOK_BND0,  },
+			{ "bnd1",  TOK_BND1,  },
+			{ "bnd2",  TOK_BND2,  },
+			{ "bnd3",  TOK_BND3,  },
+			{ "tmm0",  TOK_TMM0,  },
+			{ "tmm1",  TOK_TMM1,  },
+			{ "tmm2",  TOK_TMM2,  },
+			{ "tmm3",  TOK_TMM3,  },
+			{ "tmm4",  TOK_TMM4,  },
+			{ "tmm5",  TOK_TMM5,  },
+			{ "tmm6",  TOK_TMM6,  },
+			{ "tmm7",  TOK_TMM7,  },
+			{ "mm0",   TOK_MM0,   },
+			{ "mm1",   TOK_MM1,   },
+			{ "mm2",   TOK_MM2,   },
+			{ "mm3",   TOK_MM3,   },
+			{ "mm4",   TOK_MM4,   },
+			{ "mm5",   TOK_MM5,   },
+			{ "mm6",   TOK_MM6,   },
+			{ "mm7",   TOK_MM7,   },
+			{ "zmm0",  TOK_ZMM0,  },
+			{ "zmm1",  TOK_ZMM1,  },
+			{ "zmm2",  TOK_ZMM2,  },
+			{ "zmm3",  TOK_ZMM3,  },
+			{ "zmm4",  TOK_ZMM4,  },
+			{ "zmm5",  TOK_ZMM5,  },
+			{ "zmm6",  TOK_ZMM6,  },
+			{ "zmm7",  TOK_ZMM7,  },
+			{ "zmm8",  TOK_ZMM8,  },
+			{ "zmm9",  TOK_ZMM9,  },
+			{ "zmm10", TOK_ZMM10, },
+			{ "zmm11", TOK_ZMM11, },
+			{ "zmm12", TOK_ZMM12, },
+			{ "zmm13", TOK_ZMM13, },
+			{ "zmm14", TOK_ZMM14, },
+			{ "zmm15", TOK_ZMM15, },
+			{ "zmm16", TOK_ZMM16, },
+			{ "zmm17", TOK_ZMM17, },
+			{ "zmm18", TOK_ZMM18, },
+			{ "zmm19", TOK_ZMM19, },
+			{ "zmm20", TOK_ZMM20, },
+			{ "zmm21", TOK_ZMM21, },
+			{ "zmm22", TOK_ZMM22, },
+			{ "zmm23", TOK_ZMM23, },
+			{ "zmm24", TOK_ZMM24, },
+			{ "zmm25", TOK_ZMM25, },
+			{ "zmm26", TOK_ZMM26, },
+			{ "zmm27", TOK_ZMM27, },
+			{ "zmm28", TOK_ZMM28, },
+			{ "zmm29", TOK_ZMM29, },
+			{ "zmm30", TOK_ZMM30, },
+			{ "zmm31", TOK_ZMM31, },
+			{ "ymm0",  TOK_YMM0,  },
+			{ "ymm1",  TOK_YMM1,  },
+			{ "ymm2",  TOK_YMM2,  },
+			{ "ymm3",  TOK_YMM3,  },
+			{ "ymm4",  TOK_YMM4,  },
+			{ "ymm5",  TOK_YMM5,  },
+			{ "ymm6",  TOK_YMM6,  },
+			{ "ymm7",  TOK_YMM7,  },
+			{ "ymm8",  TOK_YMM8,  },
+			{ "ymm9",  TOK_YMM9,  },
+			{ "ymm10", TOK_YMM10, },
+			{ "ymm11", TOK_YMM11, },
+			{ "ymm12", TOK_YMM12, },
+			{ "ymm13", TOK_YMM13, },
+			{ "ymm14", TOK_YMM14, },
+			{ "ymm15", TOK_YMM15, },
+			{ "ymm16", TOK_YMM16, },
+			{ "ymm17", TOK_YMM17, },
+			{ "ymm18", TOK_YMM18, },
+			{ "ymm19", TOK_YMM19, },
+			{ "ymm20", TOK_YMM20, },
+			{ "ymm21", TOK_YMM21, },
+			{ "ymm22", TOK_YMM22, },
+			{ "ymm23", TOK_YMM23, },
+			{ "ymm24", TOK_YMM24, },
+			{ "ymm25", TOK_YMM25, },
+			{ "ymm26", TOK_YMM26, },
+			{ "ymm27", TOK_YMM27, },
+			{ "ymm28", TOK_YMM28, },
+			{ "ymm29", TOK_YMM29, },
+			{ "ymm30", TOK_YMM30, },
+			{ "ymm31", TOK_YMM31, },
+			{ "xmm0",  TOK_XMM0,  },
+			{ "xmm1",  TOK_XMM1,  },
+			{ "xmm2",  TOK_XMM2,  },
+			{ "xmm3",  TOK_XMM3,  },
+			{ "xmm4",  TOK_XMM4,  },
+			{ "xmm5",  TOK_XMM5,  },
+			{ "xmm6",  TOK_XMM6,  },
+			{ "xmm7",  TOK_XMM7,  },
+			{ "xmm8",  TOK_XMM8,  },
+			{ "xmm9",  TOK_XMM9,  },
+			{ "xmm10", TOK_XMM10, },
+			{ "xmm11", TOK_XMM11, },
+			{ "xmm12", TOK_XMM12, },
+			{ "xmm13", TOK_XMM13, },
+			{ "xmm14", TOK_XMM14, },
+			{ "xmm15", TOK_XMM15, },
+			{ "xmm16", TOK_XMM16, },
+			{ "xmm17", TOK_XMM17, },
+			{ "xmm18", TOK_XMM18, },
+			{ "xmm19", TOK_XMM19, },
+			{ "xmm20", TOK_XMM20, },
+			{ "xmm21", TOK_XMM21, },
+			{ "xmm22", TOK_XMM22, },
+			{ "xmm23", TOK_XMM23, },
+			{ "xmm24", TOK_XMM24, },
+			{ "xmm25", TOK_XMM25, },
+			{ "xmm26", TOK_XMM26, },
+			{ "xmm27", TOK_XMM27, },
+			{ "xmm28", TOK_XMM28, },
+			{ "xmm29", TOK_XMM29, },
+			{ "xmm30", TOK_XMM30, },
+			{ "xmm31", TOK_XMM31, },
+			{ "rax",   TOK_RAX,   },
+			{ "rcx",   TOK_RCX,   },
+			{ "rdx",   TOK_RDX,   },
+			{ "rbx",   TOK_RBX,   },
+			{ "rsp",   TOK_RSP,   },
+			{ "rbp",   TOK_RBP,   },
+			{ "rsi",   TOK_RSI,   },
+			{ "rdi",   TOK_RDI,   },
+			{ "r8",    TOK_R8,    },
+			{ "r9",    TOK_R9,    },
+			{ "r10",   TOK_R10,   },
+			{ "r11",   TOK_R11,   },
+			{ "r12",   TOK_R12,   },
+			{ "r13",   TOK_R13,   },
+			{ "r14",   TOK_R14,   },
+			{ "r15",   TOK_R15,   },
+			{ "eax",   TOK_EAX,   },
+			{ "ecx",   TOK_ECX,   },
+			{ "edx",   TOK_EDX,   },
+			{ "ebx",   TOK_EBX,   },
+			{ "esp",   TOK_ESP,   },
+			{ "ebp",   TOK_EBP,   },
+			{ "esi",   TOK_ESI,   },
+			{ "edi",   TOK_EDI,   },
+			{ "r8d",   TOK_R8D,   },
+			{ "r9d",   TOK_R9D,   },
+			{ "r10d",  TOK_R10D,  },
+			{ "r11d",  TOK_R11D,  },
+			{ "r12d",  TOK_R12D,  },
+			{ "r13d",  TOK_R13D,  },
+			{ "r14d",  TOK_R14D,  },
+			{ "r15d",  TOK_R15D,  },
+			{ "ax",    TOK_AX,    },
+			{ "cx",    TOK_CX,    },
+			{ "dx",    TOK_DX,    },
+			{ "bx",    TOK_BX,    },
+			{ "sp",    TOK_SP,    },
+			{ "bp",    TOK_BP,    },
+			{ "si",    TOK_SI,    },
+			{ "di",    TOK_DI,    },
+			{ "r8w",   TOK_R8W,   },
+			{ "r9w",   TOK_R9W,   },
+			{ "r10w",  TOK_R10W,  },
+			{ "r11w",  TOK_R11W,  },
+			{ "r12w",  TOK_R12W,  },
+			{ "r13w",  TOK_R13W,  },
+			{ "r14w",  TOK_R14W,  },
+			{ "r15w",  TOK_R15W,  },
+			{ "al",    TOK_AL,    },
+			{ "cl",    TOK_CL,    },
+			{ "dl",    TOK_DL,    },
+			{ "bl",    TOK_BL,    },
+			{ "spl",   TOK_SPL,   },
+			{ "bpl",   TOK_BPL,   },
+			{ "sil",   TOK_SIL,   },
+			{ "dil",   TOK_DIL,   },
+			{ "ah",    TOK_AH,    },
+			{ "ch",    TOK_CH,    },
+			{ "dh",    TOK_DH,    },
+			{ "bh",    TOK_BH,    },
+			{ "r8b",   TOK_R8B,   },
+			{ "r9b",   TOK_R9B,   },
+			{ "r10b",  TOK_R10B,  },
+			{ "r11b",  TOK_R11B,  },
+			{ "r12b",  TOK_R12B,  },
+			{ "r13b",  TOK_R13B,  },
+			{ "r14b",  TOK_R14B,  },
+			{ "r15b",  TOK_R15B   },
+
+			// types
+			{ "byte" , TOK_BYTE  },
+			{ "word" , TOK_WORD  },
+			{ "dword", TOK_DWORD },
+			{ "qword", TOK_QWORD },
+			{ "tword", TOK_TWORD },
+
+			{ "1to2",  TOK_1TO2  },
+			{ "1to4",  TOK_1TO4  },
+			{ "1to8",  TOK_1TO8  },
+			{ "1to16", TOK_1TO16 },
+			{ "1to32", TOK_1TO32 },
+
+			// keywords
+			{ "rel"    , TOK_REL     },
+			{ "section", TOK_SECTION },
+			{ "times"  , TOK_TIMES   },
+			{ "global" , TOK_GLOBAL  },
+			{ "bits"   , TOK_BITS    },
+			{ "db"     , TOK_DB      },
+			{ "dw"     , TOK_DW      },
+			{ "dd"     , TOK_DD      },
+			{ "dq"     , TOK_DQ      },
+			{ "resb"   , TOK_RESB    },
+			{ "resw"   , TOK_RESW    },
+			{ "resd"   , TOK_RESD    },
+			{ "resq"   , TOK_RESQ    },
+		};
+
+		constexpr u32 KEYWORD_COUNT = sizeof(g_keywords) / sizeof(keyword);
+		constexpr u32 KEYWORD_BUCKET_COUNT = 64;
+		constexpr u32 KEYWORD_TABLE_SIZE = 512; // power of two
+		constexpr u8 KEYWORD_MAX_LENGTH = 7;
+
+		struct keyword_entry {
+			char name[KEYWORD_MAX_LENGTH];
+			u8 length;
+			token_type token;
+		};
+
+		// keyword lookup table, generated at compile time using a hash-and-displace scheme: every
+		// keyword is first assigned a bucket, every bucket then receives a displacement which maps
+		// all of its keywords into free slots of the final table, this way every possible input
+		// string maps into exactly one slot
+		struct keyword_table {
+			u16 displacements[KEYWORD_BUCKET_COUNT];
+			keyword_entry entries[KEYWORD_TABLE_SIZE];
+		};
+
+		[[nodiscard]] constexpr auto hash_keyword(const char* str, u64 size) -> u32 {
+			// FNV-1a
+			u32 hash = 0x811c9dc5;
+
+			for(u64 i = 0; i < size; ++i) {
+				hash ^= static_cast<u8>(str[i]);
+				hash *= 0x01000193;
+			}
+
+			return hash;
+		}
+
+		[[nodiscard]] constexpr auto get_keyword_slot(u32 hash, u16 displacement) -> u32 {
+			// murmur3 finalizer over the hash mixed with the bucket displacement
+			u32 x = hash ^ (displacement * 0x9e3779b9);
+
+			x ^= x >> 16;
+			x *= 0x85ebca6b;
+			x ^= x >> 13;
+			x *= 0xc2b2ae35;
+			x ^= x >> 16;
+
+			return x & (KEYWORD_TABLE_SIZE - 1);
+		}
+
+		[[nodiscard]] constexpr auto get_keyword_length(const char* str) -> u8 {
+			u8 length = 0;
+
+			while(str[length] != '\0') {
+				length++;
+			}
+
+			return length;
+		}
+
+		[[nodiscard]] constexpr auto build_keyword_table() -> keyword_table {
+			keyword_table table = {};
+			u32 hashes[KEYWORD_COUNT] = {};
+			u32 bucket_sizes[KEYWORD_BUCKET_COUNT] = {};
+			bool bucket_done[KEYWORD_BUCKET_COUNT] = {};
+			bool occupied[KEYWORD_TABLE_SIZE] = {};
+
+			for(u32 i = 0; i < KEYWORD_COUNT; ++i) {
+				hashes[i] = hash_keyword(g_keywords[i].name, get_keyword_length(g_keywords[i].name));
+				bucket_sizes[hashes[i] % KEYWORD_BUCKET_COUNT]++;
+			}
+
+			// place the largest buckets first, since they're the hardest to fit
+			for(u32 placed = 0; placed < KEYWORD_BUCKET_COUNT; ++placed) {
+				u32 bucket = 0;
+
+				for(u32 i = 0; i < KEYWORD_BUCKET_COUNT; ++i) {
+					if(!bucket_done[i] && (bucket_done[bucket] || bucket_sizes[i] > bucket_sizes[bucket])) {
+						bucket = i;
+					}
+				}
+
+				bucket_done[bucket] = true;
+
+				// find a displacement which maps every keyword in this bucket into an empty slot
+				for(u32 displacement = 0; displacement <= utility::limits<u16>::max(); ++displacement) {
+					u32 slots[KEYWORD_COUNT] = {};
+					u32 slot_count = 0;
+					bool collision = false;
+
+					for(u32 i = 0; i < KEYWORD_COUNT && !collision; ++i) {
+						if(hashes[i] % KEYWORD_BUCKET_COUNT != bucket) {
+							continue;
+						}
+
+						const u32 slot = get_keyword_slot(hashes[i], static_cast<u16>(displacement));
+						collision = occupied[slot];
+
+						// keywords within the same bucket can collide as well
+						for(u32 j = 0; j < slot_count && !collision; ++j) {
+							collision = slots[j] == slot;
+						}
+
+						slots[slot_count++] = slot;
+					}
+
+					if(collision) {
+						continue;
+					}
+
+					// commit the bucket
+					table.displacements[bucket] = static_cast<u16>(displacement);
+
+					for(u32 i = 0; i < KEYWORD_COUNT; ++i) {
+						if(hashes[i] % KEYWORD_BUCKET_COUNT != bucket) {
+							continue;
+						}
+
+						keyword_entry& entry = table.entries[get_keyword_slot(hashes[i], static_cast<u16>(displacement))];
+						entry.length = get_keyword_length(g_keywords[i].name);
+						entry.token = g_keywords[i].token;
+
+						for(u8 j = 0; j < entry.length; ++j) {
+							entry.name[j] = g_keywords[i].name[j];
+						}
+
+						occupied[get_keyword_slot(hashes[i], static_cast<u16>(displacement))] = true;
+					}
+
+					break;
+				}
+			}
+
+			return table;
+		}
+
+		constexpr keyword_table g_keyword_table = build_keyword_table();
+
+		[[nodiscard]] constexpr auto verify_keyword_table() -> bool {
+			// every keyword has to be reachable through its own slot
+			for(const keyword& k : g_keywords) {
+				const u8 length = get_keyword_length(k.name);
+				const u32 hash = hash_keyword(k.name, length);
+				const u16 displacement = g_keyword_table.displacements[hash % KEYWORD_BUCKET_COUNT];
+				const keyword_entry& entry = g_keyword_table.entries[get_keyword_slot(hash, displacement)];
+
+				if(entry.token != k.token || entry.length != length || length > KEYWORD_MAX_LENGTH) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		static_assert(verify_keyword_table(), "failed to generate a perfect hash for lexer keywords");
+
+		// character classes which the lexer skips over in bulk
+		enum char_class : u8 {
+			CHAR_WHITESPACE, // '\t', '\v', '\f', '\r', ' ' (newlines are tokens)
+			CHAR_IDENTIFIER, // [A-Za-z0-9_.]
+			CHAR_COMMENT,    // everything except for '\n'
+		};
+
+		template<char_class type>
+		[[nodiscard]] inline auto is_char_class(char c) -> bool {
+			if constexpr(type == CHAR_WHITESPACE) {
+				return c == '\t' || c == '\v' || c == '\f' || c == '\r' || c == ' ';
+			}
+			else if constexpr(type == CHAR_IDENTIFIER) {
+				return utility::is_alphanum(c) || c == '_' || c == '.';
+			}
+			else {
+				return c != '\n';
+			}
+		}
+
+#if defined(__SSE2__)
+		// returns a mask with every byte which belongs to the character class set to 0xff
+		template<char_class type>
+		[[nodiscard]] inline auto classify_16(__m128i chunk) -> __m128i {
+			if constexpr(type == CHAR_WHITESPACE) {
+				return _mm_or_si128(
+					_mm_or_si128(
+						_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+						_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))
+					),
+					// '\v', '\f' and '\r' are consecutive
+					_mm_and_si128(
+						_mm_cmpgt_epi8(chunk, _mm_set1_epi8('\v' - 1)),
+						_mm_cmplt_epi8(chunk, _mm_set1_epi8('\r' + 1))
+					)
+				);
+			}
+			else if constexpr(type == CHAR_IDENTIFIER) {
+				// non-ascii characters are negative, and thus fall outside of all ranges
+				const __m128i lower = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+				const __m128i letter = _mm_and_si128(
+					_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+					_mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1))
+				);
+
+				const __m128i digit = _mm_and_si128(
+					_mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)),
+					_mm_cmplt_epi8(chunk, _mm_set1_epi8('9' + 1))
+				);
+
+				const __m128i special = _mm_or_si128(
+					_mm_cmpeq_epi8(chunk, _mm_set1_epi8('_')),
+					_mm_cmpeq_epi8(chunk, _mm_set1_epi8('.'))
+				);
+
+				return _mm_or_si128(_mm_or_si128(letter, digit), special);
+			}
+			else {
+				return _mm_xor_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')), _mm_set1_epi8(-1));
+			}
+		}
+#endif
+
+#if defined(__AVX2__)
+		template<char_class type>
+		[[nodiscard]] inline auto classify_32(__m256i chunk) -> __m256i {
+			if constexpr(type == CHAR_WHITESPACE) {
+				return _mm256_or_si256(
+					_mm256_or_si256(
+						_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')),
+						_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))
+					),
+					_mm256_and_si256(
+						_mm256_cmpgt_epi8(chunk, _mm256_set1_epi8('\v' - 1)),
+						_mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), chunk)
+					)
+				);
+			}
+			else if constexpr(type == CHAR_IDENTIFIER) {
+				const __m256i lower = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+				const __m256i letter = _mm256_and_si256(
+					_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+					_mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower)
+				);
+
+				const __m256i digit = _mm256_and_si256(
+					_mm256_cmpgt_epi8(chunk, _mm256_set1_epi8('0' - 1)),
+					_mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chunk)
+				);
+
+				const __m256i special = _mm256_or_si256(
+					_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('_')),
+					_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('.'))
+				);
+
+				return _mm256_or_si256(_mm256_or_si256(letter, digit), special);
+			}
+			else {
+				return _mm256_xor_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')), _mm256_set1_epi8(-1));
+			}
+		}
+#endif
+
+		// returns the numerical value of a hex digit, or 0xff if the character isn't one
+		[[nodiscard]] inline auto get_digit_value(char c) -> u8 {
+			switch(c) {
+				case '0' ... '9': return static_cast<u8>(c - '0');
+				case 'a' ... 'f': return static_cast<u8>(c - 'a' + 10);
+				case 'A' ... 'F': return static_cast<u8>(c - 'A' + 10);
+				default:          return 0xff;
+			}
+		}
+
+		// returns the index of the first character at, or after, 'index' which doesn't belong to the
+		// given character class, or 'size' if we reach the end of the text
+		template<char_class type>
+		[[nodiscard]] auto scan_char_class(const char* text, u64 index, u64 size) -> u64 {
+#if defined(__AVX2__)
+			for(; index + 32 <= size; index += 32) {
+				const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + index));
+				const u32 mask = ~static_cast<u32>(_mm256_movemask_epi8(classify_32<type>(chunk)));
+
+				if(mask) {
+					return index + __builtin_ctz(mask);
+				}
+			}
+#endif
+
+#if defined(__SSE2__)
+			for(; index + 16 <= size; index += 16) {
+				const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + index));
+				const u32 mask = ~static_cast<u32>(_mm_movemask_epi8(classify_16<type>(chunk))) & 0xffff;
+
+				if(mask) {
+					return index + __builtin_ctz(mask);
+				}
+			}
+#endif
+
+			// scalar fallback for the tail of the buffer
+			while(index < size && is_char_class<type>(text[index])) {
+				index++;
+			}
+
+			return index;
+		}
+	} // namespace detail
+
 	lexer::lexer(const utility::dynamic_string& text) {
 		set_text(text);
 	}
 
+	lexer::lexer(const utility::string_view& text) {
+		set_text(text);
+	}
+
 	void lexer::set_text(const utility::dynamic_string& text) {
+		set_text(utility::string_view(text.get_data(), text.get_size()));
+	}
+
+	void lexer::set_text(const utility::string_view& text) {
 		m_index = 0;
-		m_text = utility::dynamic_string(text);
+		m_text = text.get_data();
+		m_text_size = text.get_size();
 		get_next_char();
 	}
 
@@ -27,7 +595,16 @@ namespace baremetal::assembler {
 	}
 
 	auto lexer::is_at_end() -> bool {
-		return m_index >= m_text.get_size();
+		return m_index >= m_text_size;
+	}
+
+	auto lexer::get_current_index() -> u64 {
+		// m_index always points one past the current character, unless we've already hit the end
+		if(m_current_char == utility::g_eof && is_at_end()) {
+			return m_text_size;
+		}
+
+		return m_index - 1;
 	}
 
 	auto lexer::get_next_char_escaped() -> char {
@@ -52,15 +629,20 @@ namespace baremetal::assembler {
 		return m_current_char;
 	}
 
+	auto lexer::get_token_start() const -> u64 {
+		return m_token_start;
+	}
+
 	auto lexer::create_safepoint() -> safepoint {
 		return { .current_char = m_current_char, .index = m_index };
 	}
 
 	auto lexer::get_next_token() -> utility::result<token_type> {
-		current_string.clear();
+		current_string = utility::string_view();
 
 		// get rid of leading space-like characters
 		consume_spaces();
+		m_token_start = get_current_index();
 
 		// special characters
 		switch(m_current_char) {
@@ -92,13 +674,10 @@ namespace baremetal::assembler {
 		return utility::error("unknown character received");
 	}
 
-	auto is_whitespace(char c) -> bool {
-		return (c == '\t' || c == '\v' || c == '\f' || c == '\r' || c == ' ');
-	}
-
 	void lexer::consume_spaces() {
 		// consume spaces (excluding newlines)
-		while(is_whitespace(m_current_char)) {
+		if(detail::is_char_class<detail::CHAR_WHITESPACE>(m_current_char)) {
+			m_index = detail::scan_char_class<detail::CHAR_WHITESPACE>(m_text, m_index, m_text_size);
 			get_next_char();
 		}
 	}
@@ -106,8 +685,26 @@ namespace baremetal::assembler {
 	auto lexer::get_next_token_string() -> utility::result<token_type> {
 		get_next_char();
 
+		const u64 start = get_current_index();
+		bool escaped = false;
+
 		while(!is_at_end() && m_current_char != '"') {
-			current_string += get_next_char_escaped();
+			if(m_current_char == '\\' && !escaped) {
+				// the literal can't be represented as a span of the source anymore, copy everything up
+				// until this point into the string buffer and decode the rest of it in there
+				m_string_buffer.clear();
+
+				for(u64 i = start; i < get_current_index(); ++i) {
+					m_string_buffer += m_text[i];
+				}
+
+				escaped = true;
+			}
+
+			if(escaped) {
+				m_string_buffer += get_next_char_escaped();
+			}
+
 			get_next_char();
 		}
 
@@ -115,13 +712,20 @@ namespace baremetal::assembler {
 			return utility::error("unescaped string literal detected");
 		}
 
+		if(escaped) {
+			current_string = utility::string_view(m_string_buffer.get_data(), m_string_buffer.get_size());
+		}
+		else {
+			current_string = utility::string_view(m_text + start, get_current_index() - start);
+		}
+
 		get_next_char();
 		return current = TOK_STRING;
 	}
 
 	auto lexer::get_next_token_char() -> utility::result<token_type> {
 		get_next_char();
-		current_string = m_current_char;
+		current_string = utility::string_view(m_text + get_current_index(), 1);
 		get_next_char();
 
 		if(m_current_char != '\'') {
@@ -134,32 +738,69 @@ namespace baremetal::assembler {
 	}
 
 	auto lexer::current_string_to_number() -> utility::result<token_type> {
-		i32 base = 10;
-		char* data = current_string.get_data();
-
-		if(current_string[0] == '0' && current_string.get_size() > 1) {
-			switch(current_string[1]) {
-				case 'x':         base = 16; data += 2; break; // hex
-				case '0' ... '7': base = 8;  data += 1; break; // oct
-				case 'b':         base = 2;  data += 2; break; // bin
-				default: ASSERT(false, "unknown literal type\n");
+		const char* data = current_string.get_data();
+		const char* end = data + current_string.get_size();
+		u8 shift = 0; // log2 of the base for binary, octal and hex literals, 0 for decimal ones
+
+		if(data[0] == '0' && current_string.get_size() > 1) {
+			switch(data[1]) {
+				case 'x':         shift = 4; data += 2; break; // hex
+				case '0' ... '7': shift = 3; data += 1; break; // oct
+				case 'b':         shift = 1; data += 2; break; // bin
+				default: return utility::error("unknown numerical literal prefix");
+			}
+
+			if(data == end) {
+				return utility::error("numerical literal is missing digits");
+			}
+		}
+
+		u64 value = 0;
+
+		if(shift == 0) {
+			for(; data != end; ++data) {
+				const u8 digit = static_cast<u8>(*data - '0');
+
+				if(digit > 9) {
+					return utility::error("invalid digit in a numerical literal");
+				}
+
+				if(value > (utility::limits<u64>::max() - digit) / 10) {
+					return utility::error("numerical literal does not fit into 64 bits");
+				}
+
+				value = value * 10 + digit;
 			}
 		}
+		else {
+			for(; data != end; ++data) {
+				const u8 digit = detail::get_digit_value(*data);
 
-		const u64 number = strtoull(data, nullptr, base);
-		ASSERT(errno == 0, "strtoull failed for '{}'\n", current_string);
+				if(digit >= (1 << shift)) {
+					return utility::error("invalid digit in a numerical literal");
+				}
 
-		current_immediate = imm(number);
+				// we'd shift some of the set bits out
+				if(value >> (64 - shift)) {
+					return utility::error("numerical literal does not fit into 64 bits");
+				}
 
+				value = (value << shift) | digit;
+			}
+		}
+
+		current_immediate = imm(value);
 		return current = TOK_NUMBER;
 	}
 
 	auto lexer::get_next_token_identifier() -> utility::result<token_type> {
-		while(utility::is_alphanum(m_current_char) || m_current_char == '_' || m_current_char == '.') {
-			current_string += m_current_char;
-			get_next_char();
-		}
+		const u64 start = get_current_index();
+
+		// the first character has already been classified by get_next_token
+		m_index = detail::scan_char_class<detail::CHAR_IDENTIFIER>(m_text, m_index, m_text_size);
+		get_next_char();
 
+		current_string = utility::string_view(m_text + start, get_current_index() - start);
 		const auto token = string_to_token(current_string);
 		
 		if(token != TOK_NONE) {
@@ -175,10 +816,9 @@ namespace baremetal::assembler {
 	}
 
 	auto lexer::get_next_token_comment() -> utility::result<token_type> {
-		// skip over comments
-		do {
-			get_next_char();
-		} while(!is_at_end() && m_current_char != '\n');
+		// skip over comments, up until the next newline
+		m_index = detail::scan_char_class<detail::CHAR_COMMENT>(m_text, m_index, m_text_size);
+		get_next_char();
 
 		// return the next token
 		return get_next_token();
@@ -483,266 +1123,29 @@ namespace baremetal::assembler {
 		return {};
 	}
 
-	auto string_to_token(const utility::dynamic_string& str) -> token_type {
-		static const utility::map<utility::dynamic_string, token_type> operand_map = {
-			// registers
-			{ "cr0",   TOK_CR0,   },
-			{ "cr1",   TOK_CR1,   },
-			{ "cr2",   TOK_CR2,   },
-			{ "cr3",   TOK_CR3,   },
-			{ "cr4",   TOK_CR4,   },
-			{ "cr8",   TOK_CR8,   },
-			{ "dr0",   TOK_DR0,   },
-			{ "dr1",   TOK_DR1,   },
-			{ "dr2",   TOK_DR2,   },
-			{ "dr3",   TOK_DR3,   },
-			{ "dr4",   TOK_DR4,   },
-			{ "dr5",   TOK_DR5,   },
-			{ "dr6",   TOK_DR6,   },
-			{ "dr7",   TOK_DR7,   },
-			{ "k1",    TOK_K1,    },
-			{ "k2",    TOK_K2,    },
-			{ "k3",    TOK_K3,    },
-			{ "k4",    TOK_K4,    },
-			{ "k5",    TOK_K5,    },
-			{ "k6",    TOK_K6,    },
-			{ "k7",    TOK_K7,    },
-			{ "z",     TOK_Z,     },
-			{ "es",    TOK_ES,    },
-			{ "cs",    TOK_CS,    },
-			{ "ss",    TOK_SS,    },
-			{ "ds",    TOK_DS,    },
-			{ "fs",    TOK_FS,    },
-			{ "gs",    TOK_GS,    },
-			{ "st0",   TOK_ST0,   },
-			{ "st1",   TOK_ST1,   },
-			{ "st2",   TOK_ST2,   },
-			{ "st3",   TOK_ST3,   },
-			{ "st4",   TOK_ST4,   },
-			{ "st5",   TOK_ST5,   },
-			{ "st6",   TOK_ST6,   },
-			{ "st7",   TOK_ST7,   },
-			{ "bnd0",  TOK_BND0,  },
-			{ "bnd1",  TOK_BND1,  },
-			{ "bnd2",  TOK_BND2,  },
-			{ "bnd3",  TOK_BND3,  },
-			{ "tmm0",  TOK_TMM0,  },
-			{ "tmm1",  TOK_TMM1,  },
-			{ "tmm2",  TOK_TMM2,  },
-			{ "tmm3",  TOK_TMM3,  },
-			{ "tmm4",  TOK_TMM4,  },
-			{ "tmm5",  TOK_TMM5,  },
-			{ "tmm6",  TOK_TMM6,  },
-			{ "tmm7",  TOK_TMM7,  },
-			{ "mm0",   TOK_MM0,   },
-			{ "mm1",   TOK_MM1,   },
-			{ "mm2",   TOK_MM2,   },
-			{ "mm3",   TOK_MM3,   },
-			{ "mm4",   TOK_MM4,   },
-			{ "mm5",   TOK_MM5,   },
-			{ "mm6",   TOK_MM6,   },
-			{ "mm7",   TOK_MM7,   },
-			{ "zmm0",  TOK_ZMM0,  },
-			{ "zmm1",  TOK_ZMM1,  },
-			{ "zmm2",  TOK_ZMM2,  },
-			{ "zmm3",  TOK_ZMM3,  },
-			{ "zmm4",  TOK_ZMM4,  },
-			{ "zmm5",  TOK_ZMM5,  },
-			{ "zmm6",  TOK_ZMM6,  },
-			{ "zmm7",  TOK_ZMM7,  },
-			{ "zmm8",  TOK_ZMM8,  },
-			{ "zmm9",  TOK_ZMM9,  },
-			{ "zmm10", TOK_ZMM10, },
-			{ "zmm11", TOK_ZMM11, },
-			{ "zmm12", TOK_ZMM12, },
-			{ "zmm13", TOK_ZMM13, },
-			{ "zmm14", TOK_ZMM14, },
-			{ "zmm15", TOK_ZMM15, },
-			{ "zmm16", TOK_ZMM16, },
-			{ "zmm17", TOK_ZMM17, },
-			{ "zmm18", TOK_ZMM18, },
-			{ "zmm19", TOK_ZMM19, },
-			{ "zmm20", TOK_ZMM20, },
-			{ "zmm21", TOK_ZMM21, },
-			{ "zmm22", TOK_ZMM22, },
-			{ "zmm23", TOK_ZMM23, },
-			{ "zmm24", TOK_ZMM24, },
-			{ "zmm25", TOK_ZMM25, },
-			{ "zmm26", TOK_ZMM26, },
-			{ "zmm27", TOK_ZMM27, },
-			{ "zmm28", TOK_ZMM28, },
-			{ "zmm29", TOK_ZMM29, },
-			{ "zmm30", TOK_ZMM30, },
-			{ "zmm31", TOK_ZMM31, },
-			{ "ymm0",  TOK_YMM0,  },
-			{ "ymm1",  TOK_YMM1,  },
-			{ "ymm2",  TOK_YMM2,  },
-			{ "ymm3",  TOK_YMM3,  },
-			{ "ymm4",  TOK_YMM4,  },
-			{ "ymm5",  TOK_YMM5,  },
-			{ "ymm6",  TOK_YMM6,  },
-			{ "ymm7",  TOK_YMM7,  },
-			{ "ymm8",  TOK_YMM8,  },
-			{ "ymm9",  TOK_YMM9,  },
-			{ "ymm10", TOK_YMM10, },
-			{ "ymm11", TOK_YMM11, },
-			{ "ymm12", TOK_YMM12, },
-			{ "ymm13", TOK_YMM13, },
-			{ "ymm14", TOK_YMM14, },
-			{ "ymm15", TOK_YMM15, },
-			{ "ymm16", TOK_YMM16, },
-			{ "ymm17", TOK_YMM17, },
-			{ "ymm18", TOK_YMM18, },
-			{ "ymm19", TOK_YMM19, },
-			{ "ymm20", TOK_YMM20, },
-			{ "ymm21", TOK_YMM21, },
-			{ "ymm22", TOK_YMM22, },
-			{ "ymm23", TOK_YMM23, },
-			{ "ymm24", TOK_YMM24, },
-			{ "ymm25", TOK_YMM25, },
-			{ "ymm26", TOK_YMM26, },
-			{ "ymm27", TOK_YMM27, },
-			{ "ymm28", TOK_YMM28, },
-			{ "ymm29", TOK_YMM29, },
-			{ "ymm30", TOK_YMM30, },
-			{ "ymm31", TOK_YMM31, },
-			{ "xmm0",  TOK_XMM0,  },
-			{ "xmm1",  TOK_XMM1,  },
-			{ "xmm2",  TOK_XMM2,  },
-			{ "xmm3",  TOK_XMM3,  },
-			{ "xmm4",  TOK_XMM4,  },
-			{ "xmm5",  TOK_XMM5,  },
-			{ "xmm6",  TOK_XMM6,  },
-			{ "xmm7",  TOK_XMM7,  },
-			{ "xmm8",  TOK_XMM8,  },
-			{ "xmm9",  TOK_XMM9,  },
-			{ "xmm10", TOK_XMM10, },
-			{ "xmm11", TOK_XMM11, },
-			{ "xmm12", TOK_XMM12, },
-			{ "xmm13", TOK_XMM13, },
-			{ "xmm14", TOK_XMM14, },
-			{ "xmm15", TOK_XMM15, },
-			{ "xmm16", TOK_XMM16, },
-			{ "xmm17", TOK_XMM17, },
-			{ "xmm18", TOK_XMM18, },
-			{ "xmm19", TOK_XMM19, },
-			{ "xmm20", TOK_XMM20, },
-			{ "xmm21", TOK_XMM21, },
-			{ "xmm22", TOK_XMM22, },
-			{ "xmm23", TOK_XMM23, },
-			{ "xmm24", TOK_XMM24, },
-			{ "xmm25", TOK_XMM25, },
-			{ "xmm26", TOK_XMM26, },
-			{ "xmm27", TOK_XMM27, },
-			{ "xmm28", TOK_XMM28, },
-			{ "xmm29", TOK_XMM29, },
-			{ "xmm30", TOK_XMM30, },
-			{ "xmm31", TOK_XMM31, },
-			{ "rax",   TOK_RAX,   },
-			{ "rcx",   TOK_RCX,   },
-			{ "rdx",   TOK_RDX,   },
-			{ "rbx",   TOK_RBX,   },
-			{ "rsp",   TOK_RSP,   },
-			{ "rbp",   TOK_RBP,   },
-			{ "rsi",   TOK_RSI,   },
-			{ "rdi",   TOK_RDI,   },
-			{ "r8",    TOK_R8,    },
-			{ "r9",    TOK_R9,    },
-			{ "r10",   TOK_R10,   },
-			{ "r11",   TOK_R11,   },
-			{ "r12",   TOK_R12,   },
-			{ "r13",   TOK_R13,   },
-			{ "r14",   TOK_R14,   },
-			{ "r15",   TOK_R15,   },
-			{ "eax",   TOK_EAX,   },
-			{ "ecx",   TOK_ECX,   },
-			{ "edx",   TOK_EDX,   },
-			{ "ebx",   TOK_EBX,   },
-			{ "esp",   TOK_ESP,   },
-			{ "ebp",   TOK_EBP,   },
-			{ "esi",   TOK_ESI,   },
-			{ "edi",   TOK_EDI,   },
-			{ "r8d",   TOK_R8D,   },
-			{ "r9d",   TOK_R9D,   },
-			{ "r10d",  TOK_R10D,  },
-			{ "r11d",  TOK_R11D,  },
-			{ "r12d",  TOK_R12D,  },
-			{ "r13d",  TOK_R13D,  },
-			{ "r14d",  TOK_R14D,  },
-			{ "r15d",  TOK_R15D,  },
-			{ "ax",    TOK_AX,    },
-			{ "cx",    TOK_CX,    },
-			{ "dx",    TOK_DX,    },
-			{ "bx",    TOK_BX,    },
-			{ "sp",    TOK_SP,    },
-			{ "bp",    TOK_BP,    },
-			{ "si",    TOK_SI,    },
-			{ "di",    TOK_DI,    },
-			{ "r8w",   TOK_R8W,   },
-			{ "r9w",   TOK_R9W,   },
-			{ "r10w",  TOK_R10W,  },
-			{ "r11w",  TOK_R11W,  },
-			{ "r12w",  TOK_R12W,  },
-			{ "r13w",  TOK_R13W,  },
-			{ "r14w",  TOK_R14W,  },
-			{ "r15w",  TOK_R15W,  },
-			{ "al",    TOK_AL,    },
-			{ "cl",    TOK_CL,    },
-			{ "dl",    TOK_DL,    },
-			{ "bl",    TOK_BL,    },
-			{ "spl",   TOK_SPL,   },
-			{ "bpl",   TOK_BPL,   },
-			{ "sil",   TOK_SIL,   },
-			{ "dil",   TOK_DIL,   },
-			{ "ah",    TOK_AH,    },
-			{ "ch",    TOK_CH,    },
-			{ "dh",    TOK_DH,    },
-			{ "bh",    TOK_BH,    },
-			{ "r8b",   TOK_R8B,   },
-			{ "r9b",   TOK_R9B,   },
-			{ "r10b",  TOK_R10B,  },
-			{ "r11b",  TOK_R11B,  },
-			{ "r12b",  TOK_R12B,  },
-			{ "r13b",  TOK_R13B,  },
-			{ "r14b",  TOK_R14B,  },
-			{ "r15b",  TOK_R15B   },
-			
-			// types
-			{ "byte" , TOK_BYTE  },
-			{ "word" , TOK_WORD  },
-			{ "dword", TOK_DWORD },
-			{ "qword", TOK_QWORD },
-			{ "tword", TOK_TWORD },
-
-			{ "1to2",  TOK_1TO2  },
-			{ "1to4",  TOK_1TO4  },
-			{ "1to8",  TOK_1TO8  },
-			{ "1to16", TOK_1TO16 },
-			{ "1to32", TOK_1TO32 },
+	auto string_to_token(const utility::string_view& str) -> token_type {
+		// none of our keywords are longer than 7 characters, long identifiers (labels) can be rejected
+		// without hashing them
+		if(str.get_size() == 0 || str.get_size() > detail::KEYWORD_MAX_LENGTH) {
+			return TOK_NONE;
+		}
 
-			// keywords
-			{ "rel"    , TOK_REL     },
-			{ "section", TOK_SECTION },
-			{ "times"  , TOK_TIMES   },
-			{ "global" , TOK_GLOBAL  },
-			{ "bits"   , TOK_BITS    },
-			{ "db"     , TOK_DB      },
-			{ "dw"     , TOK_DW      },
-			{ "dd"     , TOK_DD      },
-			{ "dq"     , TOK_DQ      },
-			{ "resb"   , TOK_RESB    },
-			{ "resw"   , TOK_RESW    },
-			{ "resd"   , TOK_RESD    },
-			{ "resq"   , TOK_RESQ    },
-		};
-		
-		const auto it = operand_map.find(str);
+		const u32 hash = detail::hash_keyword(str.get_data(), str.get_size());
+		const u16 displacement = detail::g_keyword_table.displacements[hash % detail::KEYWORD_BUCKET_COUNT];
+		const detail::keyword_entry& entry = detail::g_keyword_table.entries[detail::get_keyword_slot(hash, displacement)];
 
-		if(it == operand_map.end()) {
+		// the slot is guaranteed to be the only candidate, we just have to verify that it's a match
+		if(entry.length != str.get_size()) {
 			return TOK_NONE;
 		}
 
-		return it->second;
+		for(u8 i = 0; i < entry.length; ++i) {
+			if(entry.name[i] != str.get_data()[i]) {
+				return TOK_NONE;
+			}
+		}
+
+		return entry.token;
 	}
 
 	auto token_to_string(token_type token) -> const char* {
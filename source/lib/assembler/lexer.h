@@ -338,6 +338,7 @@ namespace baremetal::assembler {
 	class lexer {
 	public:
 		lexer(const utility::dynamic_string& text);
+		lexer(const utility::string_view& text);
 		lexer() = default;
 
 		struct safepoint {
@@ -345,15 +346,22 @@ namespace baremetal::assembler {
 			u64 index;
 		};
 
+		// the lexer doesn't own its text, the caller has to keep it alive for as long as the lexer is
+		// in use
 		void set_text(const utility::dynamic_string& text);
+		void set_text(const utility::string_view& text);
 		void restore_safepoint(safepoint safepoint);
 
 		[[nodiscard]] auto get_next_token() -> utility::result<token_type>;
 		[[nodiscard]] auto create_safepoint() -> safepoint;
+
+		// offset of the first character of the current token in the source text
+		[[nodiscard]] auto get_token_start() const -> u64;
 	private:
 		auto get_next_char() -> char;
 		[[nodiscard]] auto get_next_char_escaped() -> char;
 		[[nodiscard]] auto is_at_end() -> bool;
+		[[nodiscard]] auto get_current_index() -> u64;
 
 		void consume_spaces();
 
@@ -363,11 +371,18 @@ namespace baremetal::assembler {
 		[[nodiscard]] auto get_next_token_string() -> utility::result<token_type>;
 		[[nodiscard]] auto get_next_token_char() -> utility::result<token_type>;
 	private:
-		utility::dynamic_string m_text;
+		const char* m_text = nullptr;
+		u64 m_text_size = 0;
+
+		// backing storage for string literals which contain escape sequences, everything else points
+		// directly into the source text
+		utility::dynamic_string m_string_buffer;
+
 		char m_current_char;
+		u64 m_token_start;
 		u64 m_index;
 	public:
-		utility::dynamic_string current_string;
+		utility::string_view current_string;
 		imm current_immediate;
 		token_type current;
 	};
@@ -376,7 +391,7 @@ namespace baremetal::assembler {
 	[[nodiscard]] auto token_to_string(token_type token) -> const char*;
 	[[nodiscard]] auto token_to_register(token_type token) -> reg;
 
-	[[nodiscard]] auto string_to_token(const utility::dynamic_string& str) -> token_type;
+	[[nodiscard]] auto string_to_token(const utility::string_view& str) -> token_type;
 
 	[[nodiscard]] auto is_token_broadcast(token_type token) -> bool;
 	[[nodiscard]] auto is_token_k(token_type token) -> bool;
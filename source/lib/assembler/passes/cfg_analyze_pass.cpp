@@ -3,10 +3,10 @@
 
 namespace baremetal::assembler::pass {
 	void cfg_analyze(module& module) {
-		u64 global_block_offset = 0;
-
 		// calculate control flow edges
-		for(const section& section : module.sections) {
+		for(u64 section_index = 0; section_index < module.sections.get_size(); ++section_index) {
+			const section& section = module.sections[section_index];
+
 			for(u64 i = 0; i < section.blocks.get_size(); ++i) {
 				const basic_block* block = section.blocks[i];
 
@@ -15,29 +15,31 @@ namespace baremetal::assembler::pass {
 					continue; 
 				}
 
-				const instruction_data* last_inst = block->instructions.data[block->instructions.size - 1];
+				const instruction_data& last_inst = block->instructions.data[block->instructions.size - 1];
+
+				if(is_jump_or_branch_inst(last_inst.index)) {
+					const u32 destination = module.get_operand_symbol(block, last_inst, 0);
 
-				if(is_jump_or_branch_inst(last_inst->index)) {
 					// HACK: TODO: some jump instructions are used without a symbol, handle this case
-					if(last_inst->operands[0].symbol == nullptr) {
+					if(destination == symbol_data::NONE) {
 						continue;
 					}
 
-					const u64 target_block_index = module.get_symbol(last_inst->operands[0].symbol).block_index;
-					const u64 global_block_index = global_block_offset + i;
+					// undeclared targets don't have a block, these are rejected before the passes run, but
+					// don't rely on it
+					if(!module.symbols[destination].declared) {
+						continue;
+					}
 
-					basic_block* target = module.get_block_at_index(target_block_index);
+					basic_block* target = module.get_symbol_block(module.symbols[destination]);
 					target->incoming_control_edge_count++;
 
-					if(global_block_index < module.get_block_count() - 1) {
-						// branch - fail case - incoming edge to the next block
-						module.get_block_at_index(global_block_index + 1)->incoming_control_edge_count++;
+					// branch - fail case - incoming edge to the next block
+					if(basic_block* next = module.get_next_block(section_index, i)) {
+						next->incoming_control_edge_count++;
 					}
 				}
 			}
-
-			global_block_offset += section.blocks.get_size();
 		}
 	}
 } // namespace baremetal::assembler::pass
-
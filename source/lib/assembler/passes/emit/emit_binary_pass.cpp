@@ -7,44 +7,65 @@ namespace baremetal::assembler::pass {
 	auto emit_binary(const module& module) -> utility::dynamic_array<u8> {
 		utility::dynamic_array<u8> bytes;
 
-		// reserve enough space for the entire binary dump
-		const section& last_section = module.sections[module.sections.get_size() - 1];
-		bytes.reserve(last_section.position + last_section.size);
+		bytes.resize(get_binary_size(module));
+		emit_binary(module, bytes.get_data());
+
+		return bytes;
+	}
+
+	void emit_binary(const module& module, u8* output) {
+		u64 size = 0;
 
 		// generate the final binary
 		for(const section& section : module.sections) {
 			// append alignment bytes for the previous section
-			const u64 alignment_offset = utility::align(bytes.get_size(), 4) - bytes.get_size();
+			const u64 alignment_offset = utility::align(size, 4) - size;
 			u64 local_offset = 0;
 
-			for(u64 i = 0; i < alignment_offset; ++i) {
-				bytes.push_back(0);
-			}
+			utility::memset(output + size, 0, alignment_offset);
+			size += alignment_offset;
 
 			// append individual blocks
 			for(const basic_block* block : section.blocks) {
 				if(block->is_instruction_block()) {
-					// instruction block
-					for(u64 i = 0; i < block->instructions.size; ++i) {
-						// assemble every instruction and append it
-						instruction_data* instruction = block->instructions.data[i];
-						auto data = module.resolve_instruction(instruction, section, local_offset);
-
-						utility::memcpy(bytes.get_data() + bytes.get_size(), data.data, data.size);
-						bytes.set_size(bytes.get_size() + data.size);
+					// instruction block, assembled directly into the binary
+					const u64 block_size = module.resolve_instruction_block(block, section, local_offset, output + size);
 
-						// bytes.insert(bytes.end(), data.data, data.data + data.size);
-						local_offset += instruction->size;
-					}
+					size += block_size;
+					local_offset += block_size;
 				}
 				else if(block->is_data_block()) {
 					// raw data block
-					bytes.insert(bytes.end(), block->data.data, block->data.data + block->size);
+					utility::memcpy(output + size, block->data.data, block->size);
+
+					size += block->size;
 					local_offset += block->size;
 				}
 			}
 		}
 
-		return bytes;
+		ASSERT(size == get_binary_size(module), "binary size mismatch\n");
+	}
+
+	auto get_binary_size(const module& module) -> u64 {
+		u64 size = 0;
+
+		// section and block sizes aren't kept up to date by the optimization passes, instruction sizes are
+		for(const section& section : module.sections) {
+			size = utility::align(size, 4);
+
+			for(const basic_block* block : section.blocks) {
+				if(block->is_instruction_block()) {
+					for(u64 i = 0; i < block->instructions.size; ++i) {
+						size += block->instructions.data[i].size;
+					}
+				}
+				else if(block->is_data_block()) {
+					size += block->size;
+				}
+			}
+		}
+
+		return size;
 	}
 } // namespace baremetal::assembler::pass
@@ -3,4 +3,8 @@
 
 namespace baremetal::assembler::pass {
 	[[nodiscard]] auto emit_binary(const module& module) -> utility::dynamic_array<u8>;
+
+	// emits the binary into 'output', which has to be at least get_binary_size bytes large
+	void emit_binary(const module& module, u8* output);
+	[[nodiscard]] auto get_binary_size(const module& module) -> u64;
 } // namespace baremetal::assembler::pass
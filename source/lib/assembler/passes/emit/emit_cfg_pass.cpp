@@ -11,18 +11,22 @@ namespace baremetal::assembler::pass {
 
 			// stringify all isntruction in this block
 			for(u64 i = 0; i < block->instructions.size; ++i) {
-				const instruction_data* instruction_data = block->instructions.data[i];
-				const instruction* inst = &INSTRUCTION_DB[instruction_data->index];
+				const instruction_data& instruction_data = block->instructions.data[i];
+				const instruction* inst = &INSTRUCTION_DB[instruction_data.index];
+				operand operands[4];
+
+				module.unpack_operands(block, instruction_data, operands);
 
 				// assemble the instruction (hex representation)
-				auto data = module.resolve_instruction(instruction_data, section, position);
-				auto bytes = utility::bytes_to_string(data.data, data.size, ' ');
+				u8 data[MAX_INSTRUCTION_SIZE];
+				const u8 size = module.resolve_instruction(block, instruction_data, section, position, data);
+				auto bytes = utility::bytes_to_string(data, size, ' ');
 
 				string.append(g_instruction_label, section.position + block->start_position + position, bytes, inst->name);
 
 				// stringify instruction operands (assembly representation)
 				for(u8 j = 0; j < inst->operand_count; ++j) {
-					string += operand_to_string(inst, instruction_data->operands[j], j);
+					string += operand_to_string(inst, operands[j], j);
 		
 					// separate individual operands with commas
 					if(j + 1 != inst->operand_count) {
@@ -31,7 +35,7 @@ namespace baremetal::assembler::pass {
 				}
 				
 				string += "</font></td></tr>";
-				position += instruction_data->size;
+				position += instruction_data.size;
 			}
 
 			return string;
@@ -141,7 +145,6 @@ namespace baremetal::assembler::pass {
 		utility::dynamic_string graph;
 
 		bool block_is_new_segment = true;
-		u64 global_block_offset = 0;
 		u64 current_block_id = 0;
 
 		// graphviz header
@@ -151,9 +154,11 @@ namespace baremetal::assembler::pass {
 		graph.append("\tedge [penwidth=2.0]\n\n");
 
 		// emit individual basic blocks
-		for(const section& section : module.sections) {
+		for(u64 section_index = 0; section_index < module.sections.get_size(); ++section_index) {
+			const section& section = module.sections[section_index];
+
 			for(u64 i = 0; i < section.blocks.get_size(); ++i) {
-				const u64 global_block_index = global_block_offset + i;
+				const u64 global_block_index = section.block_offset + i;
 				const basic_block* block = section.blocks[i];
 
 				// new control flow block
@@ -182,23 +187,28 @@ namespace baremetal::assembler::pass {
 				}
 
 				// generate control flow edges
-				const instruction_data* inst = block->instructions.data[block->instructions.size - 1];
+				const instruction_data& inst = block->instructions.data[block->instructions.size - 1];
 				bool is_branch = false;
 
 				// branch edge
-				if(is_jump_or_branch_inst(inst->index)) {
-					edges.push_back({ 
-						edge::BRANCH_PASS,
-						current_block_id,
-						module.get_symbol(inst->operands[0].symbol).block_index
-					});
+				if(is_jump_or_branch_inst(inst.index)) {
+					const u32 destination = module.get_operand_symbol(block, inst, 0);
+
+					// jumps without a symbol have no known destination
+					if(destination != symbol_data::NONE) {
+						edges.push_back({ 
+							edge::BRANCH_PASS,
+							current_block_id,
+							module.get_global_block_index(module.symbols[destination])
+						});
+					}
 					
 					is_branch = true;
 				}
 
 				// branch to the following control flow block (occurs when the next block has an incoming edge)
-				if(global_block_index < module.get_block_count() - 1) {
-					if(block_is_new_segment || module.get_block_at_index(global_block_index + 1)->incoming_control_edge_count) {
+				if(const basic_block* next = module.get_next_block(section_index, i)) {
+					if(block_is_new_segment || next->incoming_control_edge_count) {
 						edges.push_back({ 
 							is_branch ? edge::BRANCH_FAIL : edge::FALLTHROUGH,
 							current_block_id, 
@@ -207,8 +217,6 @@ namespace baremetal::assembler::pass {
 					}
 				}
 			}
-
-			global_block_offset += section.blocks.get_size();
 		}
 
 		graph += "</table>>]\n\n";
@@ -50,14 +50,9 @@ namespace baremetal::assembler::pass {
 		// entry point address
 		const auto entry_point_name = module.ctx->strings.add("_start");
 
-		for(const section& section : module.sections) {
-			const auto it = section.symbols.find(entry_point_name);
-
-			if(it != section.symbols.end()) {
-				const u64 entry_position = section.position + it->second.position; 
-				PUSH_U64(entry_position);	
-				break;
-			}
+		if(const symbol_data* entry_point = module.find_symbol(entry_point_name)) {
+			const u64 entry_position = module.get_global_symbol_position(*entry_point); 
+			PUSH_U64(entry_position);	
 		}
 
 		// program header table start
@@ -1,24 +1,23 @@
 #include "inst_size_minimize_pass.h"
 
 #include "assembler/backend.h"
-#include <utility/algorithms/sort.h>
 
 namespace baremetal::assembler::pass {
 	namespace detail {
-		auto get_instruction_using_magic(instruction_data* inst, const imm& imm_op) -> bool {
-			ASSERT(INSTRUCTION_DB[inst->index].has_magic(), "instruction does not have a magic number\n");
-			const u16 context_index = INSTRUCTION_DB[inst->index].get_magic_index();
+		auto get_instruction_using_magic(instruction_data& inst, const operand* operands, const imm& imm_op) -> bool {
+			ASSERT(INSTRUCTION_DB[inst.index].has_magic(), "instruction does not have a magic number\n");
+			const u16 context_index = INSTRUCTION_DB[inst.index].get_magic_index();
 
 			// switch on the context kind
-			switch(INSTRUCTION_DB[inst->index].get_magic_kind()) {
+			switch(INSTRUCTION_DB[inst.index].get_magic_kind()) {
 				case 0: {
 					// if we have a destination which uses a 64 bit register, and an operand which fits into 32 bits or
 					// less we can look for a smaller destination
-					if(inst->operands[0].type == OP_R64 && imm_op.min_bits <= 32) {
+					if(operands[0].type == OP_R64 && imm_op.min_bits <= 32) {
 						// verify if it's safe to zero extend the operand (since we're implicitly going from 32 to 64
 						// bits) we can't zero extend 
 						if(imm_op.sign == false) {
-							inst->index = context_index;
+							inst.index = context_index;
 							return true;
 						}
 					}
@@ -28,8 +27,8 @@ namespace baremetal::assembler::pass {
 				case 1: {
 					// if we have a source operand which is equal to 1, we can use a shorter encoding, in basically all
 					// cases we can just return, since the operand is effectively removed
-					if(inst->operands[1].immediate.value == 1) {
-						inst->index = context_index;
+					if(operands[1].immediate.value == 1) {
+						inst.index = context_index;
 						return true;
 					}
 
@@ -37,11 +36,11 @@ namespace baremetal::assembler::pass {
 				}
 				case 2: {
 					// truncate to 8 bits, this is only used with imul instructions
-					const u64 truncated = inst->operands[2].immediate.value & 0b011111111;
+					const u64 truncated = operands[2].immediate.value & 0b011111111;
 					const u64 extend = baremetal::assembler::detail::sign_extend(truncated, 8);
 
-					if(extend == inst->operands[2].immediate.value) {
-						inst->index = context_index;
+					if(extend == operands[2].immediate.value) {
+						inst.index = context_index;
 						return true;
 					}
 
@@ -53,17 +52,18 @@ namespace baremetal::assembler::pass {
 			return false;
 		}
 
-		void optimize_instruction_size(instruction_data* inst) {
+		void optimize_instruction_size(instruction_data& inst, const operand* operands) {
 			u8 operand_index = utility::limits<u8>::max();
 			bool has_unresolved = false;
 	
-			// locate the first unresolved/immediate operand
+			// locate the first unresolved/immediate operand, symbolic memory operands don't count, since
+			// their size doesn't depend on the symbol
 			for(u8 i = 0; i < 4; ++i) {
-				if(is_operand_imm(inst->operands[i].type)) {
+				if(is_operand_imm(operands[i].type)) {
 					operand_index = i;
 					break;
 				}
-				else if(inst->operands[i].unknown) {
+				else if(operands[i].unknown && !is_operand_mem(INSTRUCTION_DB[inst.index].operands[i])) {
 					has_unresolved = true;
 					operand_index = i;
 					break;
@@ -75,48 +75,33 @@ namespace baremetal::assembler::pass {
 				return;
 			}
 	
-			const imm& imm_op = inst->operands[operand_index].immediate;
-			u32 legal_variants[5];
-			u8 legal_variants_index = 0;
+			const imm& imm_op = operands[operand_index].immediate;
 	
 			// some instructions have a special optimization index, check if we have it
-			if(INSTRUCTION_DB[inst->index].has_magic() && has_unresolved == false) {
-				if(get_instruction_using_magic(inst, imm_op)) {
+			if(INSTRUCTION_DB[inst.index].has_magic() && has_unresolved == false) {
+				if(get_instruction_using_magic(inst, operands, imm_op)) {
 					return;
 				}
 			}
 	
-			// locate all legal variants of our instruction
-			u32 current_index = inst->index;
-	
-			while(is_legal_variant(inst->index, current_index, operand_index)) {
-				legal_variants[legal_variants_index++] = current_index++;
-			}
-	
-			// sort by the smallest source operands, we need to do this for cases where one of the
-			// variants has a destination operand which isn't a generic register, but a specific
-			// one (ie. an ax register). In these cases we lose the guarantee of them being sorted
-			// from smallest to biggest immediate operands, hence we have to sort them.
-			utility::stable_sort(legal_variants, legal_variants + legal_variants_index, [=](auto a, auto b) {
-				const instruction* a_inst = &INSTRUCTION_DB[a];
-				const instruction* b_inst = &INSTRUCTION_DB[b];
-	
-				const u16 a_width = get_operand_bit_width(a_inst->operands[operand_index]);
-				const u16 b_width = get_operand_bit_width(b_inst->operands[operand_index]);
-	
-				return a_width < b_width;
-			});
+			// locate all legal variants of our instruction, these are already sorted by the smallest
+			// source operands, which is something we need for cases where one of the variants has a
+			// destination operand which isn't a generic register, but a specific one (ie. an ax
+			// register). In these cases we lose the guarantee of the database being sorted from
+			// smallest to biggest immediate operands.
+			const instruction_variants legal_variants = get_instruction_variants(inst.index, operand_index);
 
 			if(has_unresolved) {
 				// instructions with unresolved operands can just use the largest variant
-				ASSERT(legal_variants_index > 0, "no variants found\n");
-				inst->index = legal_variants[legal_variants_index - 1];
+				ASSERT(legal_variants.count > 0, "no variants found\n");
+				inst.index = legal_variants.indices[legal_variants.count - 1];
 				return;
 			}
 
 			// multiple legal variants, determine the best one (since our data is sorted from smallest
 			// source operands to largest, we can exit as soon as we get a valid match)
-			for(u32 index : legal_variants) {
+			for(u8 i = 0; i < legal_variants.count; ++i) {
+				const u32 index = legal_variants.indices[i];
 				const instruction* curr = &INSTRUCTION_DB[index];
 
 				const u16 src_bits = get_operand_bit_width(curr->operands[operand_index]);
@@ -128,14 +113,14 @@ namespace baremetal::assembler::pass {
 
 					// assume we're sign extending
 					if(baremetal::assembler::detail::sign_extend_representable(imm_op.value, static_cast<u8>(src_bits))) {
-						inst->index = index;
+						inst.index = index;
 						return;
 					}
 				}
 
 				// check if the source operand is representable with a smaller immediate
 				if(src_bits >= imm_op.min_bits) {
-					inst->index = index;
+					inst.index = index;
 					return;
 				}
 			}
@@ -145,24 +130,31 @@ namespace baremetal::assembler::pass {
 	} // namespace detail
 
 	void inst_size_minimize(module& module) {
-		for(const section& section : module.sections) {
+		for(section& section : module.sections) {
 			for(const basic_block* block : section.blocks) {
 				if(!block->is_instruction_block()) {
 					continue;
 				}
 
 				for(u64 i = 0; i < block->instructions.size; ++i) {
-					instruction_data* inst = block->instructions.data[i];
-					u32 old_index = inst->index;
-					detail::optimize_instruction_size(inst);
+					instruction_data& inst = block->instructions.data[i];
+					operand operands[4];
+					u32 old_index = inst.index;
+
+					module.unpack_operands(block, inst, operands);
+					detail::optimize_instruction_size(inst, operands);
+
+					// instructions which don't have to be resolved won't change anymore, encode them once
+					// for every later emit, this also updates their size
+					module.encode_instruction(section, inst, operands);
 
-					if(inst->index != old_index) {
+					if(inst.index != old_index && inst.encoded == instruction_data::NOT_ENCODED) {
 						// HACK: recalculate the size, this needs to be done in a different way
-						u8 old_size = inst->size;
-						inst->size = backend::emit_instruction(&INSTRUCTION_DB[inst->index], inst->operands).size;
+						u8 old_size = inst.size;
+						inst.size = backend::compute_size(&INSTRUCTION_DB[inst.index], operands);
 	
-						if(old_size > inst->size) {
-							ASSERT(inst->size <= old_size, "[inst minimize]: minimized instruction is bigger than the original variant {} -> {}\n", old_size, inst->size);
+						if(old_size > inst.size) {
+							ASSERT(inst.size <= old_size, "[inst minimize]: minimized instruction is bigger than the original variant {} -> {}\n", old_size, inst.size);
 						}
 					}
 				}
@@ -3,8 +3,8 @@
 
 namespace baremetal::assembler::pass {
 	namespace detail {
-		[[nodiscard]] auto get_instruction_using_magic(instruction_data* inst, const imm& imm_op) -> bool;
-		void optimize_instruction_size(instruction_data* inst);
+		[[nodiscard]] auto get_instruction_using_magic(instruction_data& inst, const operand* operands, const imm& imm_op) -> bool;
+		void optimize_instruction_size(instruction_data& inst, const operand* operands);
 	} // namespace detail
 
 	void inst_size_minimize(module& module);
@@ -4,13 +4,78 @@
 
 namespace baremetal::assembler::pass {
 	namespace detail {
-		auto collect_unresolved_symbols(const section& section) -> utility::dynamic_array<unresolved_symbol> {
+		void position_tree::build(const utility::dynamic_array<u64>& sizes) {
+			const u64 count = sizes.get_size();
+
+			m_tree.clear();
+			m_tree.resize(count + 1);
+
+			for(u64 i = 0; i < count; ++i) {
+				m_tree[i + 1] = static_cast<i64>(sizes[i]);
+			}
+
+			// push every partial sum into its parent
+			for(u64 i = 1; i <= count; ++i) {
+				const u64 parent = i + (i & (~i + 1));
+
+				if(parent <= count) {
+					m_tree[parent] += m_tree[i];
+				}
+			}
+		}
+
+		void position_tree::add(u64 index, i64 delta) {
+			for(u64 i = index + 1; i < m_tree.get_size(); i += i & (~i + 1)) {
+				m_tree[i] += delta;
+			}
+		}
+
+		auto position_tree::get_position(u64 index) const -> u64 {
+			i64 position = 0;
+
+			for(u64 i = index; i > 0; i -= i & (~i + 1)) {
+				position += m_tree[i];
+			}
+
+			return static_cast<u64>(position);
+		}
+
+		auto fits_into_type(i64 value, operand_type type) -> bool {
+			switch(type) {
+				case OP_REL8:
+				case OP_REL8_RIP:  return value >= utility::limits<i8>::min() && value <= utility::limits<i8>::max();
+				case OP_REL16_RIP: return value >= utility::limits<i16>::min() && value <= utility::limits<i16>::max();
+				case OP_REL32:     return value >= utility::limits<i32>::min() && value <= utility::limits<i32>::max();
+				default: ASSERT(false, "unexpected operand type {}\n", operand_type_to_string(type));
+			}
+
+			return false;
+		}
+
+		// switches the instruction to the specified variant of its symbolic operand
+		void set_variant(module& module, basic_block* block, instruction_data& inst, operand* operands, u8 operand_index, u16 index) {
+			operands[operand_index].type = INSTRUCTION_DB[index].operands[operand_index];
+			module.set_operand_type(block, inst, operand_index, operands[operand_index].type);
+
+			inst.index = index;
+			inst.size = backend::compute_size(&INSTRUCTION_DB[index], operands);
+		}
+
+		// collects the sizes of the items of the section, the index of the first item of every block
+		// (followed by the item count), and the references which can be relaxed, these start out as
+		// their smallest variant, every other symbolic reference uses its largest variant
+		auto collect_unresolved_symbols(module& module, u64 section_index, utility::dynamic_array<u64>& sizes, utility::dynamic_array<u64>& block_items) -> utility::dynamic_array<unresolved_symbol> {
+			const section& section = module.sections[section_index];
 			utility::dynamic_array<unresolved_symbol> unresolved;
-			u64 local_pos = 0;
 
-			// for every instruction block in this section
 			for(u64 i = 0; i < section.blocks.get_size(); ++i) {
-				const basic_block* block = section.blocks[i];
+				basic_block* block = section.blocks[i];
+				block_items.push_back(sizes.get_size());
+
+				if(block->is_data_block()) {
+					sizes.push_back(block->size);
+					continue;
+				}
 
 				if(!block->is_instruction_block()) {
 					continue;
@@ -19,127 +84,129 @@ namespace baremetal::assembler::pass {
 				// check for symbolic references in all instructions
 				// TODO: collect these references when constructing the module?
 				for(u64 j = 0; j < block->instructions.size; ++j) {
-					instruction_data* inst = block->instructions.data[j];
+					instruction_data& inst = block->instructions.data[j];
+					operand operands[4];
+					u32 symbols[4];
 
-					for(u8 k= 0; k < 4; ++k) {
-						auto variants = backend::get_variants_i(inst->index, inst->operands);
+					module.unpack_operands(block, inst, operands, symbols);
 
+					// every symbolic operand selects its variant independently, the variants of an operand
+					// keep the types of the other operands, hence we start with the variant selected for
+					// the previous operand
+					for(u8 k = 0; k < 4; ++k) {
 						// skip operands which don't have a symbol
-						if(inst->operands[k].symbol == nullptr) {
+						if(symbols[k] == symbol_data::NONE) {
 							continue;
 						}
 
-						const auto symbol_it = section.symbols.find(inst->operands[k].symbol);
-						
-						auto last = variants.pop_back();
-						inst->operands[k].type = last.type;
-						inst->index = last.index;
-						inst->size = backend::emit_instruction(&INSTRUCTION_DB[inst->index], inst->operands).size;
-
-						// we can only optimize references to symbols in the same section
-						if(symbol_it == section.symbols.end()) {
-							break;
+						// symbolic memory operands always use 32-bit displacements, their variant depends on the
+						// size of the memory location, which has already been selected
+						if(is_operand_mem(INSTRUCTION_DB[inst.index].operands[k])) {
+							continue;
 						}
 
-						// right now we can only optimize relative offsets
-						if(!is_operand_rel(inst->operands[k].type)) {
-							break;
+						const symbol_data& symbol = module.symbols[symbols[k]];
+						const instruction_variants variants = get_instruction_variants(inst.index, k);
+						ASSERT(variants.count > 0, "no variants found\n");
+
+						u8 variant = variants.count - 1;
+
+						// we can only relax relative references to symbols in the same section, absolute
+						// references are addresses, which use the largest variant
+						if(
+							symbol.declared &&
+							symbol.section_index == section_index &&
+							is_operand_rel(INSTRUCTION_DB[variants.indices[variant]].operands[k])
+						) {
+							variant = 0;
+
+							// start with the smallest relative variant
+							while(!is_operand_rel(INSTRUCTION_DB[variants.indices[variant]].operands[k])) {
+								variant++;
+							}
+
+							// the target block is translated into an item once we've seen every block
+							unresolved.push_back({ i, j, sizes.get_size(), symbol.block_index, k, variant, variants });
 						}
 
-						unresolved.push_back({ i, j, k, local_pos, variants });
-						
-						// TODO: we can't optimize multiple symbols per instruction yet
-						break;
+						set_variant(module, block, inst, operands, k, variants.indices[variant]);
 					}
 
-					local_pos += block->instructions.data[j]->size;
+					sizes.push_back(inst.size);
 				}
 			}
 
-			return utility::move(unresolved);
-		}
+			// symbols declared at the end of the section point past the last block
+			block_items.push_back(sizes.get_size());
 
-		auto fits_into_type(i64 value, operand_type type) -> bool {
-			switch(type) {
-				case OP_REL8:
-				case OP_REL8_RIP:  return value >= utility::limits<i8>::min() && value <= utility::limits<i8>::max();
-				case OP_REL16_RIP: return value >= utility::limits<i16>::min() && value <= utility::limits<i16>::max();
-				case OP_REL32:     return value >= utility::limits<i32>::min() && value <= utility::limits<i32>::max();
-				default: ASSERT(false, "unexpected operand type {}\n", operand_type_to_string(type));
-			}
-	
-			return false;
-		}
-		
-		void shift_symbols(section& section, u64 position, i64 shift) {
-			for(auto& [sym_name, sym_position] : section.symbols) {
-				if(sym_position.position > position) {
-					sym_position.position -= shift;
-				}
+			for(unresolved_symbol& current : unresolved) {
+				current.target_item_index = block_items[current.target_item_index];
 			}
-		}
 
-		void shift_unresolved(utility::dynamic_array<unresolved_symbol>& unresolved, u64 position, i64 shift) {
-			for(auto& u : unresolved) {
-				if(u.position > position) {
-					u.position -= shift;
-				}
-			}
+			return unresolved;
 		}
 	} // namespace detail
 
 	void symbolic_minimize(module& module) {
-		// minimize individual sections (we can't optimize symbolic references across sections) 
-		for(section& section : module.sections) {
-			auto unresolved = detail::collect_unresolved_symbols(section);
+		// minimize individual sections (we can't optimize symbolic references across sections)
+		for(u64 section_index = 0; section_index < module.sections.get_size(); ++section_index) {
+			section& section = module.sections[section_index];
+			utility::dynamic_array<u64> sizes;
+			utility::dynamic_array<u64> block_items;
+			detail::position_tree positions;
+
+			auto unresolved = detail::collect_unresolved_symbols(module, section_index, sizes, block_items);
+			positions.build(sizes);
+
+			// grow references which don't fit, references never shrink, hence we're guaranteed to reach a
+			// point where every reference fits
 			bool change = true;
 
-			// resolve and optimize symbol references within each section
 			while(change) {
 				change = false;
 
-				// optimize symbol references, try to use the smallest possible operand
-				for(auto& current : unresolved) {
-					if(current.variants.is_empty()) {
-						// this element is already as optimized as it can be 
+				for(detail::unresolved_symbol& current : unresolved) {
+					// references which already use their largest variant can't grow
+					if(current.variant + 1 == current.variants.count) {
 						continue;
 					}
 
-					basic_block* current_block = section.blocks[current.block_index];
-					instruction_data* current_inst = current_block->instructions.data[current.instruction_index];
-					operand& operand = current_inst->operands[current.unresolved_index];
-					const auto symbol_it = section.symbols.find(operand.symbol);
+					basic_block* block = section.blocks[current.block_index];
+					instruction_data& inst = block->instructions.data[current.instruction_index];
+					const operand_type type = INSTRUCTION_DB[inst.index].operands[current.unresolved_index];
 
-					// we shouldn't receive symbols from different sections
-					ASSERT(symbol_it != section.symbols.end(), "symbol from a different section received\n");
+					// same as in module::resolve_instruction, relative to the end of the instruction
+					const u64 position = positions.get_position(current.item_index) + inst.size;
+					const i64 distance = static_cast<i64>(positions.get_position(current.target_item_index) - position);
 
-					// calculate the distance to the target symbol
-					const i64 distance = symbol_it->second.position - current.position + current_inst->size;
-					const operand_type new_type = current.variants.get_last().type;
-
-					if(!pass::detail::fits_into_type(distance, new_type)) {
-						// we can't use a smaller operand, no optimization possible in this iteration
+					if(detail::fits_into_type(distance, type)) {
 						continue;
 					}
 
-					// success, we can use the smaller variant
-					operand.type = new_type;
+					// move on to the next relative variant
+					do {
+						current.variant++;
+					} while(!is_operand_rel(INSTRUCTION_DB[current.variants.indices[current.variant]].operands[current.unresolved_index]));
 
-					const instruction* inst = &INSTRUCTION_DB[current.variants.get_last().index];
-					const u8 new_size = backend::emit_instruction(inst, current_inst->operands).size;
+					operand operands[4];
+					const u8 old_size = inst.size;
 
-					// update our symbol table to account for the difference in code length
-					detail::shift_symbols(section, current.position, current_inst->size - new_size);
-					detail::shift_unresolved(unresolved, current.position, current_inst->size - new_size);
+					module.unpack_operands(block, inst, operands);
+					detail::set_variant(module, block, inst, operands, current.unresolved_index, current.variants.indices[current.variant]);
 
-					current_inst->index = current.variants.pop_back().index;
-					current_inst->size = new_size;
+					positions.add(current.item_index, static_cast<i64>(inst.size) - old_size);
 					change = true;
-
-					// TODO: investigate whether it's better to break immediately or continue
-					break;
 				}
 			}
+
+			// update our symbol table to account for the difference in code length
+			for(const u32 id : section.symbols) {
+				symbol_data& symbol = module.symbols[id];
+				symbol.position = positions.get_position(block_items[symbol.block_index]);
+			}
 		}
+
+		// sections which follow a resized section have moved
+		module.recalculate_block_sizes();
 	}
 } // namespace baremetal::assembler::pass
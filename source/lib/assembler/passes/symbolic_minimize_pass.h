@@ -4,22 +4,38 @@
 
 namespace baremetal::assembler::pass {
 	namespace detail {
+		// fenwick tree over the sizes of the items of a section (instructions and data blocks, in order),
+		// the position of an item is the sum of the sizes of the items before it
+		class position_tree {
+		public:
+			// O(n) construction
+			void build(const utility::dynamic_array<u64>& sizes);
+
+			void add(u64 index, i64 delta);
+			[[nodiscard]] auto get_position(u64 index) const -> u64;
+		private:
+			utility::dynamic_array<i64> m_tree; // 1-based
+		};
+
 		struct unresolved_symbol {
 			u64 block_index;       // source block
 			u64 instruction_index; // source instruction
+			u64 item_index;        // source item (see position_tree)
+			u64 target_item_index; // item the target symbol is located at
 			u8 unresolved_index;   // source operand
-			u64 position;          // byte position within the parent section
-			
-			// possible variants for the unresolved operand, sorted by size
-			utility::dynamic_array<inst_variant> variants; 
+			u8 variant;            // current variant
+
+			// variants of the unresolved operand, sorted by size, starting with the smallest one, relative
+			// operands are the only variable operand of their instruction, hence growing them never undoes
+			// the variants selected for other symbolic operands
+			instruction_variants variants;
 		};
 
-		[[nodiscard]] auto collect_unresolved_symbols(const section& section) -> utility::dynamic_array<unresolved_symbol>;
 		[[nodiscard]] auto fits_into_type(i64 value, operand_type type) -> bool;
-		
-		void shift_unresolved(utility::dynamic_array<unresolved_symbol>& unresolved, u64 position, i64 shift);
-		void shift_symbols(section& section, u64 position, i64 shift);
 	} // namespace detail
 
+	// resolves relative references to symbols in the same section using optimistic relaxation: every
+	// reference starts out as its smallest variant, references which don't fit are grown one variant
+	// at a time until no reference changes
 	void symbolic_minimize(module& module);
 } // namespace baremetal::assembler::pass
@@ -0,0 +1,96 @@
+#include "token_stream.h"
+
+namespace baremetal::assembler {
+	auto token_stream::tokenize(const utility::string_view& source) -> utility::result<void> {
+		// offsets and lengths are stored as 32 bit integers
+		if(source.get_size() > utility::limits<u32>::max()) {
+			return utility::error("source files larger than 4GB are not supported");
+		}
+
+		m_source = source.get_data();
+		m_index = 0;
+
+		m_kinds.clear();
+		m_offsets.clear();
+		m_lengths.clear();
+		m_payloads.clear();
+		m_immediates.clear();
+		m_strings.clear();
+
+		lexer lexer(source);
+
+		while(true) {
+			TRY(const token_type token, lexer.get_next_token());
+
+			const char* text = lexer.current_string.get_data();
+			u32 offset = static_cast<u32>(lexer.get_token_start());
+			u32 payload = NO_PAYLOAD;
+
+			if(token == TOK_NUMBER) {
+				payload = static_cast<u32>(m_immediates.get_size());
+				m_immediates.push_back(lexer.current_immediate);
+			}
+			else if(token == TOK_STRING && text != m_source + offset + 1) {
+				// string literals containing escape sequences live in the lexer's string buffer, which
+				// is reused for every literal, move them over to our arena
+				payload = static_cast<u32>(m_strings.get_size());
+
+				for(u64 i = 0; i < lexer.current_string.get_size(); ++i) {
+					m_strings += lexer.current_string[i];
+				}
+			}
+			else if(text) {
+				offset = static_cast<u32>(text - m_source);
+			}
+
+			m_kinds.push_back(token);
+			m_offsets.push_back(offset);
+			m_lengths.push_back(static_cast<u32>(lexer.current_string.get_size()));
+			m_payloads.push_back(payload);
+
+			if(token == TOK_EOF) {
+				break;
+			}
+		}
+
+		return SUCCESS;
+	}
+
+	auto token_stream::get_next_token() -> token_type {
+		ASSERT(m_kinds.get_size() > 0, "token stream hasn't been tokenized\n");
+		const u64 index = m_index;
+
+		// the last token is always TOK_EOF, don't move past it
+		if(m_index + 1 < m_kinds.get_size()) {
+			m_index++;
+		}
+
+		const u32 payload = m_payloads[index];
+		current = m_kinds[index];
+
+		if(current == TOK_NUMBER) {
+			current_immediate = m_immediates[payload];
+		}
+
+		if(current == TOK_STRING && payload != NO_PAYLOAD) {
+			current_string = utility::string_view(m_strings.get_data() + payload, m_lengths[index]);
+		}
+		else {
+			current_string = utility::string_view(m_source + m_offsets[index], m_lengths[index]);
+		}
+
+		return current;
+	}
+
+	void token_stream::restore_safepoint(safepoint safepoint) {
+		m_index = safepoint.index;
+	}
+
+	auto token_stream::create_safepoint() const -> safepoint {
+		return { .index = m_index };
+	}
+
+	auto token_stream::get_token_count() const -> u64 {
+		return m_kinds.get_size();
+	}
+} // namespace baremetal::assembler
@@ -0,0 +1,54 @@
+// pre-lexed representation of a source file. the whole file is tokenized up front into a compact
+// structure of arrays, which the frontend then walks by index. since every token stays around for
+// the lifetime of the stream, replaying a part of the source (ie. the 'times' directive) is just a
+// matter of resetting the index.
+//
+// every token is described by:
+// - kind:    the token type
+// - offset:  offset of the token text in the source (or in the string arena, see below)
+// - length:  length of the token text
+// - payload: index into the immediate array for numbers, offset into the string arena for string
+//            literals which contain escape sequences, NO_PAYLOAD otherwise
+
+#pragma once
+#include "assembler/lexer.h"
+
+namespace baremetal::assembler {
+	class token_stream {
+	public:
+		token_stream() = default;
+
+		struct safepoint {
+			u64 index;
+		};
+
+		// the source text isn't copied, it has to outlive the token stream
+		[[nodiscard]] auto tokenize(const utility::string_view& source) -> utility::result<void>;
+
+		// advances to the next token, once we reach the end every subsequent call returns TOK_EOF
+		auto get_next_token() -> token_type;
+
+		void restore_safepoint(safepoint safepoint);
+		[[nodiscard]] auto create_safepoint() const -> safepoint;
+
+		[[nodiscard]] auto get_token_count() const -> u64;
+	private:
+		static constexpr u32 NO_PAYLOAD = utility::limits<u32>::max();
+
+		const char* m_source = nullptr;
+
+		utility::dynamic_array<token_type> m_kinds;
+		utility::dynamic_array<u32> m_offsets;
+		utility::dynamic_array<u32> m_lengths;
+		utility::dynamic_array<u32> m_payloads;
+
+		utility::dynamic_array<imm> m_immediates;
+		utility::dynamic_string m_strings; // decoded string literals (only those with escape sequences)
+
+		u64 m_index = 0; // index of the next token
+	public:
+		utility::string_view current_string;
+		imm current_immediate;
+		token_type current = TOK_NONE;
+	};
+} // namespace baremetal::assembler
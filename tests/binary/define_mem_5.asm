@@ -0,0 +1,36 @@
+; expect: b0226c696e652030310a6c696e652030320a6c696e652030330a6c696e652030340a6c696e652030350a6c696e652030360a6c696e652030370a6c696e652030380a6c696e652030390a6c696e652031300a6c696e652031310a6c696e652031320a6c696e652031330a6c696e652031340a6c696e652031350a6c696e652031360a6c696e652031370a6c696e652031380a6c696e652031390a6c696e652032300a6c696e652032310a6c696e652032320a6c696e652032330a6c696e652032340a00b03b90
+
+bits 64
+
+; chunks are split at line boundaries, newlines inside of string literals don't end a line (neither
+; do the quotes in this comment: ", ')
+
+section .text
+	mov al, '"'
+	msg db "line 01
+line 02
+line 03
+line 04
+line 05
+line 06
+line 07
+line 08
+line 09
+line 10
+line 11
+line 12
+line 13
+line 14
+line 15
+line 16
+line 17
+line 18
+line 19
+line 20
+line 21
+line 22
+line 23
+line 24
+", 0
+	mov al, ';'
+	nop
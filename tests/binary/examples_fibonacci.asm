@@ -1,5 +1,6 @@
 ; source: https://rosettacode.org/wiki/Anonymous_recursion 
 ; expect: b930000000bb3000000029cb5368490000005589e55331c0678b5d0883fb017c23b801000000741cffcb53e8e2ffffff67890424ffcb53e8d6ffffff670344240483c4085b89ec5dc367890c2450e80f00000083c40459e2acb80100000031dbcd805589e583ec0b678d4dff67c6010a678b4508bb0a000000ffc931d2f7f380c23067881183f8007fefb804000000bb0100000089ea29cacd8089ec5dc3
+; jit: reject
 bits 64
 
 ; global  _start
@@ -0,0 +1,23 @@
+; expect: 909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090eb8090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090e97cffffffeb7f90909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090e9800000009090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090909090
+bits 64
+
+section .text
+
+; relative references are encoded relative to the end of the instruction, make sure we only use
+; rel8 displacements when they actually fit
+backward_fits:
+	times 126 nop
+	jmp backward_fits
+
+backward_grows:
+	times 127 nop
+	jmp backward_grows
+
+	jmp forward_fits
+	times 127 nop
+
+forward_fits:
+	jmp forward_grows
+	times 128 nop
+
+forward_grows:
@@ -0,0 +1,17 @@
+; expect: eb2e48c7042502000000300000004883b802000000014088b802000000f20f2a0425300000000fb6042530000000ebd248813c253000000002000000
+; jit: reject
+
+bits 64
+
+; every symbolic operand is resolved on its own, symbolic memory operands always use 32-bit
+; displacements, even when combined with a base register
+	jmp b
+a:
+	mov qword [a], b
+	cmp qword [rax + a], 1
+	mov byte [a + rax], dil
+	cvtsi2sd xmm0, dword [b]
+	movzx eax, byte [b]
+	jmp a
+b:
+	cmp qword [b], a
@@ -1,4 +1,5 @@
 ; expect: b804000000bb01000000b920000000ba0d000000cd80b80100000031dbcd800048656c6c6f2c20576f726c642100010203341278563412f0debc9a78563412010203040501000000020000000300000004000000
+; jit: reject
 bits 64
 
 section .data
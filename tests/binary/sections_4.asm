@@ -1,5 +1,6 @@
 ; skip
 ; expect: c680070000000a0000000000000000000000000000000000000000
+; jit: reject
 bits 64
 
 mov byte[alphabet + rax], 0x0a
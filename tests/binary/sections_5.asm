@@ -1,5 +1,6 @@
 ; skip
 ; expect: c680080000000a000000000000000000000000000000000000000000
+; jit: reject
 bits 64
 
 section .text
@@ -0,0 +1,6 @@
+; test parser edge cases (trailing comment without a newline at the end of the file)
+; expect: 0f05
+
+bits 64
+
+syscall ; comment
\ No newline at end of file
@@ -0,0 +1,7 @@
+; test parser edge cases (escaped string literals)
+; expect: 610962706c61696e785c79227a0a
+
+bits 64
+
+data0 db "a\tb"
+data1 db "plain", "x\\y\"z", 10
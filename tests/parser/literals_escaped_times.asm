@@ -0,0 +1,6 @@
+; test parser edge cases (replayed escaped string literals)
+; expect: 6109620061096200
+
+bits 64
+
+times 2 db "a\tb", 0
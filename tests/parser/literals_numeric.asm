@@ -0,0 +1,8 @@
+; test parser edge cases (numerical literals)
+; expect: ffffffffffffffffffffffffffffffffffffffffffffffffefbeadde0a0000000f00000000000000ff7f00
+
+bits 64
+
+data0 dq 0xffffffffffffffff, 18446744073709551615, 01777777777777777777777
+data1 dd 0xDEADbeef, 0b1010, 017, 0
+data2 db 255, 0x7f, 00
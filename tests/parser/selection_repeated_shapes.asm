@@ -0,0 +1,32 @@
+; test instruction selection (repeated instruction shapes)
+; expect: 4889c84889d34889f34d89c84d89da83c00183c30283c10300d800d14000de4000df48894424084889430848890348890148898300100000488981001000004889548b084a89548b084a89549308c5e858cbc5d058e6c4c16858cbc4c16858cc62616cc958cb62615cca58d5
+
+bits 64
+
+mov rax, rcx
+mov rbx, rdx
+mov rbx, rsi
+mov r8, r9
+mov r10, r11
+add eax, 1
+add ebx, 2
+add ecx, 3
+add al, bl
+add cl, dl
+add sil, bl
+add dil, bl
+mov qword [rsp + 8], rax
+mov qword [rbx + 8], rax
+mov qword [rbx], rax
+mov qword [rcx], rax
+mov qword [rbx + 0x1000], rax
+mov qword [rcx + 0x1000], rax
+mov qword [rbx + rcx * 4 + 8], rdx
+mov qword [rbx + r9 * 4 + 8], rdx
+mov qword [rbx + r10 * 4 + 8], rdx
+vaddps xmm1, xmm2, xmm3
+vaddps xmm4, xmm5, xmm6
+vaddps xmm1, xmm2, xmm11
+vaddps xmm1, xmm2, xmm12
+vaddps zmm17{k1}{z}, zmm2, zmm3
+vaddps zmm18{k2}{z}, zmm4, zmm5
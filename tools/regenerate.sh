@@ -3,6 +3,7 @@
 # regenerates all automatically generated files, including: 
 # - db.json
 # - instruction_database.inc
+# - instruction_index.inc
 
 SCRIPT_DIR="$(dirname "$(realpath "$0")")"
 
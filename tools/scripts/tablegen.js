@@ -1,6 +1,7 @@
-// generates a table for the instruction database
+// generates a table for the instruction database, the index used for instruction selection, the
+// opcode tables used by the decoder, or the mnemonic functions of the builder
 
-// expected arguments: {source_database.json}
+// expected arguments: {source_database.json} [table|index|decoder|builder]
 const utility = require("./utility.js")
 const fs = require('fs');
 
@@ -194,10 +195,450 @@ function calculate_magic(inst, dest_to_source) {
 	return 65535; // u16 max - no special index
 }
 
+// operand classes, used to build operand signatures for the instruction index, has to match the
+// operand_class enum in lib/assembler/instruction/instruction_index.h
+function get_operand_class(op) {
+	switch(op) {
+		case 'r8': case 'al': case 'cl':                        return 1;  // OC_R8
+		case 'r16': case 'ax': case 'dx':                       return 2;  // OC_R16
+		case 'r32': case 'eax': case 'ecx': case 'edx':         return 3;  // OC_R32
+		case 'r64': case 'rax': case 'rcx':                     return 4;  // OC_R64
+		case 'xmm': case 'xmm_k': case 'xmm_kz':                return 5;  // OC_XMM
+		case 'ymm': case 'ymm_k': case 'ymm_kz':                return 6;  // OC_YMM
+		case 'zmm': case 'zmm_k': case 'zmm_kz':                return 7;  // OC_ZMM
+		case 'k': case 'k_k':                                   return 8;  // OC_K
+		case 'sreg': case 'es': case 'cs': case 'ss':
+		case 'ds': case 'fs': case 'gs':                        return 9;  // OC_SREG
+		case 'st': case 'st0':                                  return 10; // OC_ST
+		case 'tmm': case 'mmx': case 'dreg': case 'creg':
+		case 'bnd':                                             return 11; // OC_REG
+		case 'moff8': case 'moff16': case 'moff32':
+		case 'moff64':                                          return 13; // OC_MOFF
+		case '1': case 'i8': case 'i16': case 'i32': case 'i64':
+		case 'rel8': case 'rel16': case 'rel32':
+		case 'rel8_rip': case 'rel16_rip': case 'rel32_rip':    return 14; // OC_IMM
+		default: {
+			// memory, masked memory, vsib and broadcast operands
+			if(op === 'mem' || op === 'tmem' || op === 'mib' || op.startsWith('m') || op.startsWith('vm') || op.startsWith('b')) {
+				return 12; // OC_MEM
+			}
+
+			console.error(`unknown operand class for operand '${op}'`);
+			return 0;
+		}
+	}
+}
+
+// signature of the first 'count' operands, 4 bits per operand class, the count lives in the upper bits
+function get_operand_signature(operands, count) {
+	let signature = count << 16;
+
+	for(let i = 0; i < count; ++i) {
+		signature |= get_operand_class(operands[i]) << (i * 4);
+	}
+
+	return signature;
+}
+
+// has to match hash_mnemonic in lib/assembler/instruction/instruction_index.h (32 bit FNV-1a)
+function hash_mnemonic(name) {
+	let hash = 2166136261;
+
+	for(let i = 0; i < name.length; ++i) {
+		hash ^= name.charCodeAt(i);
+		hash = Math.imul(hash, 16777619) >>> 0;
+	}
+
+	return hash;
+}
+
+// has to match hash_signature in lib/assembler/instruction/instruction_index.h
+function hash_signature(signature) {
+	return (Math.imul(signature, 0x9E3779B1) >>> 0) >>> 16;
+}
+
+function to_hex(value, width) {
+	return `0x${value.toString(16).padStart(width, '0')}`;
+}
+
+function format_list(values, per_line) {
+	let lines = [];
+
+	for(let i = 0; i < values.length; i += per_line) {
+		lines.push(`\t${values.slice(i, i + per_line).join(', ')},`);
+	}
+
+	return lines.join('\n');
+}
+
+function generate_index(instructions) {
+	const mnemonic_table_size = 4096; // has to match MNEMONIC_TABLE_SIZE
+	const empty_signature = 0xffffffff;
+
+	let mnemonic_table = new Array(mnemonic_table_size).fill(0xffff);
+	let mnemonics = [];
+	let signature_table = [];
+	let candidates = [];
+
+	// split the (sorted) database into mnemonic groups
+	for(let i = 0; i < instructions.length;) {
+		let end = i;
+
+		while(end < instructions.length && instructions[end].name === instructions[i].name) {
+			end++;
+		}
+
+		mnemonics.push({ name: instructions[i].name, first: i, count: end - i });
+		i = end;
+	}
+
+	mnemonics.forEach((mnemonic, id) => {
+		// mnemonic lookup, linear probing
+		let slot = hash_mnemonic(mnemonic.name) % mnemonic_table_size;
+
+		while(mnemonic_table[slot] !== 0xffff) {
+			slot = (slot + 1) % mnemonic_table_size;
+		}
+
+		mnemonic_table[slot] = id;
+
+		// operand matching only looks at the operands which were provided, hence every variant is a
+		// candidate for every prefix of its operand list, candidates are kept in database order
+		let lists = new Map();
+
+		for(let i = mnemonic.first; i < mnemonic.first + mnemonic.count; ++i) {
+			const operands = instructions[i].operands;
+
+			for(let count = 0; count <= operands.length; ++count) {
+				const signature = get_operand_signature(operands, count);
+
+				if(!lists.has(signature)) {
+					lists.set(signature, []);
+				}
+
+				lists.get(signature).push(i);
+			}
+		}
+
+		let size = 1;
+
+		while(size < lists.size * 2) {
+			size *= 2;
+		}
+
+		let table = new Array(size).fill(null);
+
+		lists.forEach((list, signature) => {
+			let slot = hash_signature(signature) & (size - 1);
+
+			while(table[slot] !== null) {
+				slot = (slot + 1) & (size - 1);
+			}
+
+			table[slot] = { signature: signature, first: candidates.length, count: list.length };
+			candidates.push(...list);
+		});
+
+		mnemonic.signatures = signature_table.length;
+		mnemonic.mask = size - 1;
+
+		table.forEach(entry => {
+			signature_table.push(entry === null ? { signature: empty_signature, first: 0, count: 0 } : entry);
+		});
+	});
+
+	let result = [];
+
+	result.push('constexpr mnemonic MNEMONIC_DB[] = {');
+	result.push(format_list(mnemonics.map(m => `{ ${to_hex(m.first, 4)}, ${to_hex(m.count, 2)}, ${to_hex(m.signatures, 5)}, ${to_hex(m.mask, 3)} }`), 4));
+	result.push('};\n');
+	result.push('constexpr u16 MNEMONIC_TABLE[] = {');
+	result.push(format_list(mnemonic_table.map(id => to_hex(id, 4)), 16));
+	result.push('};\n');
+	result.push('constexpr signature SIGNATURE_TABLE[] = {');
+	result.push(format_list(signature_table.map(s => `{ ${to_hex(s.signature >>> 0, 8)}, ${to_hex(s.first, 4)}, ${to_hex(s.count, 2)} }`), 4));
+	result.push('};\n');
+	result.push('constexpr u16 CANDIDATE_DB[] = {');
+	result.push(format_list(candidates.map(c => to_hex(c, 4)), 16));
+	result.push('};');
+
+	return result.join('\n');
+}
+
+// has to match is_operand_imm, is_operand_rel and is_operand_mem in lib/assembler/instruction/operands/operands.h
+function is_variable_operand(op) {
+	switch(op) {
+		case 'i8': case 'i16': case 'i32': case 'i64':
+		case 'rel8': case 'rel16': case 'rel32':
+		case 'rel8_rip': case 'rel16_rip': case 'rel32_rip':
+		case 'mem': case 'tmem': case 'm8': case 'm16': case 'm16_k': case 'm32': case 'm32_k':
+		case 'vm32x': case 'vm32y': case 'vm32z': case 'vm32x_k': case 'vm32y_k': case 'vm32z_k':
+		case 'm64': case 'm64_k':
+		case 'vm64x': case 'vm64y': case 'vm64z': case 'vm64x_k': case 'vm64y_k': case 'vm64z_k':
+		case 'm80': case 'm128': case 'm128_k': case 'm256': case 'm256_k': case 'm512': case 'm512_k': return true;
+		default: return false;
+	}
+}
+
+// has to match get_operand_bit_width in lib/assembler/instruction/operands/operands.h
+function get_operand_bit_width(op) {
+	switch(op) {
+		case 'i8': case 'r8': case 'al': case 'cl': case 'moff8': case 'm8': case 'rel8_rip': case 'rel8': return 8;
+		case 'i16': case 'r16': case 'sreg': case 'gs': case 'es': case 'fs': case 'ss': case 'ds': case 'cs':
+		case 'ax': case 'b16': case 'dx': case 'moff16': case 'rel16': case 'rel16_rip': case 'm16': case 'm16_k': return 16;
+		case 'i32': case 'r32': case 'eax': case 'ecx': case 'edx': case 'b32': case 'moff32': case 'm32': case 'm32_k':
+		case 'rel32_rip': case 'vm32x': case 'vm32y': case 'vm32z': case 'vm32x_k': case 'vm32y_k': case 'vm32z_k':
+		case 'rel32': return 32;
+		case 'i64': case 'r64': case 'moff64': case 'm64': case 'm64_k': case 'creg': case 'dreg': case 'mmx': case 'bnd':
+		case 'rcx': case 'rax': case 'mib': case 'k_k': case 'k': case 'vm64x': case 'vm64y': case 'vm64z':
+		case 'vm64x_k': case 'vm64y_k': case 'vm64z_k': case 'b64': return 64;
+		case 'm80': case 'st': case 'st0': return 80;
+		case 'xmm': case 'xmm_k': case 'xmm_kz': case 'm128': case 'm128_k': return 128;
+		case 'ymm': case 'ymm_k': case 'ymm_kz': case 'm256': case 'm256_k': return 256;
+		case 'zmm': case 'zmm_k': case 'zmm_kz': case 'm512': case 'm512_k': return 512;
+		case 'tmem': case 'tmm': return 1024;
+		default: return 0;
+	}
+}
+
+// has to match is_legal_operand_variant in lib/assembler/backend.cpp
+function is_legal_operand_variant(a, b) {
+	switch(a) {
+		case 'al':  return b === 'al'  || b === 'cl'  || b === 'r8';
+		case 'ax':  return b === 'ax'  || b === 'dx'  || b === 'r16';
+		case 'eax': return b === 'eax' || b === 'ecx' || b === 'r32';
+		case 'rax': return b === 'rax' || b === 'rcx' || b === 'r64';
+		default:    return a === b;
+	}
+}
+
+// has to match is_legal_variant in lib/assembler/backend.cpp
+function is_legal_variant(instructions, a, b, operand_index) {
+	if(b >= instructions.length || instructions[a].name !== instructions[b].name) {
+		return false;
+	}
+
+	const a_operands = instructions[a].operands;
+	const b_operands = instructions[b].operands;
+
+	for(let i = 0; i < a_operands.length; ++i) {
+		if(i !== operand_index && !is_legal_operand_variant(a_operands[i], b_operands[i] ?? 'none')) {
+			return false;
+		}
+	}
+
+	return is_variable_operand(b_operands[operand_index] ?? 'none');
+}
+
+// every variant of every instruction, which only differs in the specified operand (immediates,
+// relocations and memory operands), sorted by the bit width of the operand (stable)
+function generate_variants(instructions) {
+	let ranges = [];
+	let variants = [];
+
+	instructions.forEach((_, index) => {
+		for(let operand_index = 0; operand_index < 4; ++operand_index) {
+			let list = [];
+
+			for(let current = index; is_legal_variant(instructions, index, current, operand_index); ++current) {
+				list.push(current);
+			}
+
+			const width = i => get_operand_bit_width(instructions[i].operands[operand_index]);
+			list.sort((a, b) => width(a) - width(b) || a - b);
+
+			ranges.push({ first: list.length === 0 ? 0 : variants.length, count: list.length });
+			variants.push(...list);
+		}
+	});
+
+	let result = [];
+
+	result.push('constexpr variant_range VARIANT_TABLE[] = {');
+	result.push(format_list(ranges.map(r => `{ ${to_hex(r.first, 4)}, ${to_hex(r.count, 1)} }`), 8));
+	result.push('};\n');
+	result.push('constexpr u16 VARIANT_DB[] = {');
+	result.push(format_list(variants.map(v => to_hex(v, 4)), 16));
+	result.push('};');
+
+	return result.join('\n');
+}
+
+// hot part of every instruction, contains everything instruction selection looks at, has to match
+// instruction_selection in lib/assembler/instruction/instruction_index.h
+function generate_selection(instructions) {
+	const broadcast_bits = { 'b16': 16, 'b32': 32, 'b64': 64 };
+	let rows = [];
+
+	instructions.forEach(inst => {
+		const operands = [0, 1, 2, 3].map(i => {
+			const op = inst.operands[i] ?? 'none';
+			return `OP_${(op === '1' ? 'hidden' : op).toUpperCase()}`;
+		});
+
+		// number of broadcast elements (vector size / element size)
+		const broadcast = inst.operands.find(op => op in broadcast_bits);
+		const broadcast_n = broadcast === undefined ? 0 : Number(inst.size) / broadcast_bits[broadcast];
+
+		rows.push([...operands, inst.enc.includes('EVEX') ? '1' : '0', `${broadcast_n}`]);
+	});
+
+	const layout = utility.calculate_layout(rows);
+	let result = [];
+
+	result.push('constexpr instruction_selection SELECTION_DB[] = {');
+	result.push(utility.apply_layout(layout, rows, '\t{ ', ' },').trimEnd());
+	result.push('};');
+
+	return result.join('\n');
+}
+
+// opcode maps the decoder looks instructions up in, has to match opcode_map in
+// lib/assembler/decoder.h
+const decoder_maps = {
+	legacy: 0, legacy_0f: 1, legacy_0f38: 2, legacy_0f3a: 3,
+	vex_0f: 4, vex_0f38: 5, vex_0f3a: 6,
+	xop_9: 7, xop_a: 8,
+	evex_0f: 9, evex_0f38: 10, evex_0f3a: 11, evex_5: 12, evex_6: 13
+};
+
+const decoder_map_count = 14;
+
+function is_legacy_encoding(enc) {
+	return ['R', 'M', 'MR', 'RM', 'RMR', 'NORMAL', 'NORMALD'].includes(enc);
+}
+
+// locates the opcode map and the opcode byte the decoder uses to find the instruction, the returned
+// length is the number of opcode bytes which follow the escape bytes (ie. 2 for 'd9 c0+i')
+function get_decoder_key(inst) {
+	let bytes = [];
+
+	for(let i = 0; i < inst.opcode.length; i += 2) {
+		bytes.push(parseInt(inst.opcode.substring(i, i + 2), 16));
+	}
+
+	let escape = 0;
+
+	if(bytes[0] === 0x0f && bytes.length > 1) {
+		escape = bytes.length > 2 && (bytes[1] === 0x38 || bytes[1] === 0x3a) ? 2 : 1;
+	}
+
+	let map = ['', '0f', escape === 2 ? `0f${bytes[1].toString(16)}` : ''][escape];
+
+	// the first instruction of a double instruction is handled like a prefix
+	if(inst.enc === 'NORMALD') {
+		return { map: decoder_maps.legacy, opcode: bytes[bytes.length - 1], length: 1 };
+	}
+
+	if(is_legacy_encoding(inst.enc)) {
+		return {
+			map: decoder_maps[map === '' ? 'legacy' : `legacy_${map}`],
+			opcode: bytes[escape],
+			length: bytes.length - escape
+		};
+	}
+
+	// VEX, XOP and EVEX instructions only contain the last opcode byte, the rest is a part of the prefix
+	const opcode = bytes[bytes.length - 1];
+
+	if(inst.enc.startsWith('XOP')) {
+		return { map: inst.enc === 'XOP' ? decoder_maps.xop_9 : decoder_maps.xop_a, opcode: opcode, length: 1 };
+	}
+
+	if(inst.enc.startsWith('EVEX')) {
+		if(inst.map !== '') {
+			return { map: decoder_maps[`evex_${inst.map}`], opcode: opcode, length: 1 };
+		}
+
+		return { map: decoder_maps[`evex_${map}`], opcode: opcode, length: 1 };
+	}
+
+	return { map: decoder_maps[`vex_${map}`], opcode: opcode, length: 1 };
+}
+
+// candidate variants for every opcode byte of every opcode map, instructions whose opcode carries a
+// register (opcode + r) are listed under all 8 opcodes. candidates with longer opcodes (ie. x87
+// register forms) are more specific, hence they're checked first
+function generate_decoder(instructions) {
+	let lists = Array.from({ length: decoder_map_count * 256 }, () => []);
+
+	instructions.forEach((inst, index) => {
+		const key = get_decoder_key(inst);
+
+		if(key.map === undefined) {
+			console.error(`unknown opcode map for instruction '${inst.name}' (${inst.opcode})`);
+			return;
+		}
+
+		const register_count = inst.ri !== '' && key.length === 1 ? 8 : 1;
+
+		for(let i = 0; i < register_count; ++i) {
+			lists[key.map * 256 + key.opcode + i].push({ index: index, length: key.length });
+		}
+	});
+
+	let ranges = [];
+	let candidates = [];
+
+	lists.forEach(list => {
+		if(list.length > 255) {
+			console.error(`too many decoder candidates for a single opcode (${list.length})`);
+		}
+
+		list.sort((a, b) => b.length - a.length || a.index - b.index);
+
+		ranges.push({ first: list.length === 0 ? 0 : candidates.length, count: list.length });
+		candidates.push(...list.map(c => c.index));
+	});
+
+	let result = [];
+
+	result.push('constexpr opcode_range DECODER_TABLE[] = {');
+	result.push(format_list(ranges.map(r => `{ ${to_hex(r.first, 4)}, ${to_hex(r.count, 2)} }`), 8));
+	result.push('};\n');
+	result.push('constexpr u16 DECODER_DB[] = {');
+	result.push(format_list(candidates.map(c => to_hex(c, 4)), 16));
+	result.push('};');
+
+	return result.join('\n');
+}
+
+// mnemonics which aren't valid C++ identifiers get a trailing underscore, has to match builder.h
+const reserved_names = new Set(['and', 'not', 'or', 'xor', 'int']);
+
+// every mnemonic gets a member function of the builder, which forwards its operands to
+// builder::emit, the mnemonic ID is a template argument so that the variant can be selected at
+// compile time
+function generate_builder(instructions) {
+	let result = [];
+	let mnemonic_id = 0;
+
+	for(let i = 0; i < instructions.length; ++i) {
+		// mnemonic IDs are assigned in the same order as the mnemonic groups in generate_index
+		if(i !== 0 && instructions[i - 1].name === instructions[i].name) {
+			continue;
+		}
+
+		const name = instructions[i].name + (reserved_names.has(instructions[i].name) ? '_' : '');
+
+		result.push(`template<typename... types> auto ${name}(const types&... operands) -> utility::result<void> { return emit<${to_hex(mnemonic_id, 3)}>(operands...); }`);
+		mnemonic_id++;
+	}
+
+	return result.join('\n');
+}
+
 function main() {
 	// handle inputs
-	if(process.argv.length != 3) {
-		console.error(`expected 1 argument but got ${process.argv.length - 2} arguments instead`);
+	if(process.argv.length != 3 && process.argv.length != 4) {
+		console.error(`expected 1 or 2 arguments but got ${process.argv.length - 2} arguments instead`);
+		return 1;
+	}
+
+	const mode = process.argv.length === 4 ? process.argv[3] : 'table';
+
+	if(mode !== 'table' && mode !== 'index' && mode !== 'decoder' && mode !== 'builder') {
+		console.error(`unknown output mode '${mode}'`);
 		return 1;
 	}
 	
@@ -253,12 +694,39 @@ function main() {
 		lookup.set(`${inst.name}:${inst.encoding}:${inst.operands.join(":")}`, i);
 	});
 
+	if(mode === 'index') {
+		console.log(generate_index(instructions));
+		console.log('');
+		console.log(generate_variants(instructions));
+		console.log('');
+		console.log(generate_selection(instructions));
+		return 0;
+	}
+
+	if(mode === 'decoder') {
+		console.log(generate_decoder(instructions));
+		return 0;
+	}
+
+	if(mode === 'builder') {
+		console.log(generate_builder(instructions));
+		return 0;
+	}
+
 	// generate the table
-	instructions.forEach(inst => {
+	let mnemonic_id = -1;
+
+	instructions.forEach((inst, i) => {
 		let special_index = calculate_magic(inst, dest_to_source, lookup);
 		let row = [];
 
+		// mnemonic IDs are assigned in the same order as the mnemonic groups in generate_index
+		if(i === 0 || instructions[i - 1].name !== inst.name) {
+			mnemonic_id++;
+		}
+
 		row.push(`"${inst.name}"`);			                                          // name
+		row.push(`${get_base_prefix()}${mnemonic_id.toString(constant_base)}`);   // mnemonic ID
 		row.push(`ENC_${inst.enc}`);    	                                        // encoding
 		row.push(`${get_base_prefix()}${get_instruction_prefix(inst.prefix)}`);	  // prefix
 		row.push(`0x${inst.opcode}`);                                             // opcode
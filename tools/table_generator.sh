@@ -1,7 +1,9 @@
 # !/bin/bash 
-# generates instruction_database.inc from db.json
+# generates the instruction database, index, decoder and builder tables from db.json
 
 SCRIPT_DIR="$(dirname "$(realpath "$0")")"
 
 node "$SCRIPT_DIR/scripts/tablegen.js" "$SCRIPT_DIR/scripts/db.json" > "$SCRIPT_DIR/../source/lib/assembler/instruction/databases/database.inc"
-
+node "$SCRIPT_DIR/scripts/tablegen.js" "$SCRIPT_DIR/scripts/db.json" index > "$SCRIPT_DIR/../source/lib/assembler/instruction/databases/index.inc"
+node "$SCRIPT_DIR/scripts/tablegen.js" "$SCRIPT_DIR/scripts/db.json" decoder > "$SCRIPT_DIR/../source/lib/assembler/instruction/databases/decoder.inc"
+node "$SCRIPT_DIR/scripts/tablegen.js" "$SCRIPT_DIR/scripts/db.json" builder > "$SCRIPT_DIR/../source/lib/assembler/instruction/databases/builder.inc"